@@ -0,0 +1,102 @@
+//
+//  BassBoost.cpp
+//
+//  The bass boost stage of the signal chain.
+//
+
+#include "BassBoost.h"
+
+#include <cmath>
+
+
+namespace
+{
+constexpr float kFrequency = 110.0f;  // Center frequency in Hz
+constexpr float kQ = 0.7f;            // Q factor for musical width
+
+// Response(): probe level (well inside the Svf's linear range), and the
+// decay below which the tail is dropped, held for kTailWindow samples.
+constexpr float kProbe = 0.001f;
+constexpr float kTailThreshold = 0.00001f;
+constexpr size_t kTailWindow = 256;
+
+void _InitFilter(daisysp::Svf& filter, float sampleRate)
+{
+  filter.Init(sampleRate);
+  filter.SetFreq(kFrequency);
+  filter.SetRes(kQ);
+}
+} // namespace
+
+
+BassBoost::BassBoost()
+{
+}
+
+// Destructor
+BassBoost::~BassBoost()
+{
+    // No Code Needed
+}
+
+
+void BassBoost::Init(float sampleRate)
+{
+  mSampleRate = sampleRate;
+  _InitFilter(mFilter, mSampleRate);
+}
+
+void BassBoost::Reset()
+{
+  _InitFilter(mFilter, mSampleRate);
+}
+
+size_t BassBoost::Response(float wetGain, float* taps, size_t maxTaps) const
+{
+  daisysp::Svf filter;
+  _InitFilter(filter, mSampleRate);
+
+  size_t length = 0;
+  size_t quiet = 0;
+  for (size_t i = 0; i < maxTaps && quiet < kTailWindow; i++)
+  {
+    const float input = i == 0 ? kProbe : 0.0f;
+    filter.Process(input);
+    const float peak = filter.Peak() / kProbe;
+    taps[i] = (i == 0 ? 1.0f : 0.0f) + peak * wetGain;
+    if (i > 0 && std::fabs(peak * wetGain) < kTailThreshold)
+    {
+      quiet++;
+    }
+    else
+    {
+      quiet = 0;
+      length = i + 1;
+    }
+  }
+  return length;
+}
+
+void BassBoost::ProcessBlock(const float* inputs, float* outputs, size_t numFrames, float wetGain)
+{
+  for (size_t i = 0; i < numFrames; i++)
+  {
+    const float input = inputs[i];
+    mFilter.Process(input);
+    // Blend dry signal with boosted peak output
+    outputs[i] = input + mFilter.Peak() * wetGain;
+  }
+}
+
+void BassBoost::ProcessBlock(const float* inputs, float* outputs, size_t numFrames, float startGain, float endGain)
+{
+  const float step = numFrames > 0 ? (endGain - startGain) / (float)numFrames : 0.0f;
+  float wetGain = startGain;
+  for (size_t i = 0; i < numFrames; i++)
+  {
+    const float input = inputs[i];
+    wetGain += step;
+    mFilter.Process(input);
+    outputs[i] = input + mFilter.Peak() * wetGain;
+  }
+}
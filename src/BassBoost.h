@@ -0,0 +1,47 @@
+//
+//  BassBoost.h
+//
+//  The bass boost stage of the signal chain: an SVF peak band at 110 Hz
+//  blended onto the dry signal. Shared by the firmware and the offline
+//  renderer (tools/ir_render.cpp), so both run the same DSP.
+//
+
+#pragma once
+
+#include <cstddef>
+
+#include "daisysp.h"
+
+
+class BassBoost
+{
+public:
+  // Wet gain range of the boost knob: 0 (off) to ~12 dB.
+  static constexpr float kMaxGain = 3.0f;
+
+  BassBoost();
+  ~BassBoost();
+
+  void Init(float sampleRate);
+  // Clear the filter state, e.g. before resuming after a stretch where the
+  // boost was folded into the IR and ProcessBlock() wasn't called.
+  void Reset();
+
+  // outputs[i] = inputs[i] + peak band of inputs[i] * wetGain.
+  // `inputs` and `outputs` may alias.
+  void ProcessBlock(const float* inputs, float* outputs, size_t numFrames, float wetGain);
+  // As above, with the wet gain ramping linearly from `startGain` (before
+  // the first sample) to `endGain` (at the last).
+  void ProcessBlock(const float* inputs, float* outputs, size_t numFrames, float startGain, float endGain);
+
+  // Impulse response of the whole stage (dry plus peak band) at `wetGain`,
+  // into `taps`, cut off once it has decayed below audibility or at
+  // `maxTaps`. Returns the length. Doesn't touch the running filter.
+  // Measured at low level: the Svf's drive term is a mild cubic
+  // nonlinearity, so this is its small-signal (linear) response.
+  size_t Response(float wetGain, float* taps, size_t maxTaps) const;
+
+private:
+  float mSampleRate = 48000.0f;
+  daisysp::Svf mFilter;
+};
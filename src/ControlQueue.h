@@ -0,0 +1,109 @@
+//
+//  ControlQueue.h
+//
+//  Wait-free single-producer/single-consumer queue for control changes from
+//  the main loop to the audio callback, plus the per-parameter ramp the
+//  callback smooths them with.
+//
+//  The main loop does all ADC reads and parameter mapping and pushes plain
+//  values; the audio callback drains the queue at the start of each block.
+//  Neither side ever blocks: Push() fails when the queue is full and the
+//  producer retries on its next pass.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+
+// `Capacity` must be a power of two; one slot is never used, so the queue
+// holds up to Capacity - 1 messages.
+template <typename T, size_t Capacity>
+class ControlQueue
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer only. Returns false (and drops nothing already queued) when full.
+  bool Push(const T& message)
+  {
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    const size_t next = (head + 1) & (Capacity - 1);
+    if (next == mTail.load(std::memory_order_acquire))
+      return false;
+    mMessages[head] = message;
+    // Publishes the message to the consumer.
+    mHead.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false when empty.
+  bool Pop(T& message)
+  {
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail == mHead.load(std::memory_order_acquire))
+      return false;
+    message = mMessages[tail];
+    // Hands the slot back to the producer.
+    mTail.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+    return true;
+  }
+
+private:
+  T mMessages[Capacity];
+  // Next slot to write, producer owned.
+  std::atomic<size_t> mHead{0};
+  // Next slot to read, consumer owned.
+  std::atomic<size_t> mTail{0};
+};
+
+
+// Linear ramp from the current value to the last target, consumer side.
+// Advance() steps it one block at a time; the block's start and end values
+// let the DSP interpolate per sample.
+class ParameterRamp
+{
+public:
+  // Jump to `value`; later targets are reached over `rampFrames` samples.
+  void Init(float value, size_t rampFrames)
+  {
+    mValue = value;
+    mTarget = value;
+    mStep = 0.0f;
+    mRemaining = 0;
+    mRampFrames = rampFrames > 0 ? rampFrames : 1;
+  }
+
+  void SetTarget(float target)
+  {
+    mTarget = target;
+    mStep = (target - mValue) / (float)mRampFrames;
+    mRemaining = mRampFrames;
+  }
+
+  // Move `numFrames` samples along the ramp; returns the new value.
+  float Advance(size_t numFrames)
+  {
+    if (numFrames >= mRemaining)
+    {
+      mValue = mTarget;
+      mRemaining = 0;
+    }
+    else
+    {
+      mValue += mStep * (float)numFrames;
+      mRemaining -= numFrames;
+    }
+    return mValue;
+  }
+
+  float Value() const { return mValue; }
+
+private:
+  float mValue = 0.0f;
+  float mTarget = 0.0f;
+  float mStep = 0.0f;
+  size_t mRemaining = 0;
+  size_t mRampFrames = 1;
+};
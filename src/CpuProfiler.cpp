@@ -0,0 +1,60 @@
+//
+//  CpuProfiler.cpp
+//
+//  Cycle-accurate load meter for the audio callback.
+//
+
+#include "CpuProfiler.h"
+
+
+#if CPU_PROFILE
+namespace
+{
+const char* const kStageNames[] = {"callback", "boost", "ir"};
+
+// Cycles as a percentage of `deadline`, in tenths.
+uint32_t _LoadPermille(uint32_t cycles, uint32_t deadline)
+{
+  return deadline > 0 ? (uint32_t)((uint64_t)cycles * 1000 / deadline) : 0;
+}
+} // namespace
+#endif
+
+
+void CpuProfiler::Init(size_t blockSize, float sampleRate)
+{
+  mDeadline = (uint32_t)((float)SystemCoreClock * (float)blockSize / sampleRate);
+#if CPU_CYCLE_COUNTER
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->LAR = 0xC5ACCE55;  // Unlock the DWT (required on the M7)
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+bool CpuProfiler::Report(daisy::DaisySeed& seed)
+{
+#if CPU_PROFILE
+  const uint32_t overruns = mOverruns;
+  seed.PrintLine("cpu: deadline %lu cycles, %lu overruns (+%lu)", (unsigned long)mDeadline,
+                 (unsigned long)overruns, (unsigned long)(overruns - mReportedOverruns));
+  for (size_t i = 0; i < (size_t)Stage::Count; i++)
+  {
+    const Stats stats = mStats[i];
+    const uint32_t load = _LoadPermille(stats.average, mDeadline);
+    const uint32_t peak = _LoadPermille(stats.peak, mDeadline);
+    seed.PrintLine("  %-8s cur %6lu avg %6lu (%lu.%lu%%) peak %6lu (%lu.%lu%%)", kStageNames[i],
+                   (unsigned long)stats.current, (unsigned long)stats.average,
+                   (unsigned long)(load / 10), (unsigned long)(load % 10), (unsigned long)stats.peak,
+                   (unsigned long)(peak / 10), (unsigned long)(peak % 10));
+  }
+  mResetPeaks = true;
+
+  const bool missed = overruns != mReportedOverruns;
+  mReportedOverruns = overruns;
+  return missed;
+#else
+  (void)seed;
+  return false;
+#endif
+}
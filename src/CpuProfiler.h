@@ -0,0 +1,113 @@
+//
+//  CpuProfiler.h
+//
+//  Cycle-accurate load meter for the audio callback, using the Cortex-M7
+//  DWT cycle counter (CYCCNT).
+//
+//  The callback times each stage with Now() and hands the deltas to
+//  Record(). Per stage the profiler keeps the last, a running average and
+//  the peak cycle count, and counts callbacks that ran past the block
+//  deadline. The main loop prints a summary over USB serial with Report().
+//
+//  Only built in with CPU_PROFILE=1 (make CPU_PROFILE=1). Otherwise every
+//  call is an empty inline and the callback pays nothing, apart from Now(),
+//  which the overload guard also reads (see OverloadGuard.h). Init() starts
+//  the cycle counter for tracing too (see Trace.h).
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "daisy_seed.h"
+#include "stm32h7xx_hal.h"
+
+#include "OverloadGuard.h"
+#include "Trace.h"
+
+
+#ifndef CPU_PROFILE
+#define CPU_PROFILE 0
+#endif
+
+// The cycle counter runs for any of its users.
+#define CPU_CYCLE_COUNTER (CPU_PROFILE || OVERLOAD_GUARD || TRACE)
+
+
+class CpuProfiler
+{
+public:
+  enum class Stage
+  {
+    Callback,     // The whole callback
+    BassBoost,
+    Convolution,  // IRManager::ProcessBlock, including any crossfade
+    Count
+  };
+
+  struct Stats
+  {
+    uint32_t current = 0;  // Cycles of the last callback
+    uint32_t average = 0;  // Running average over ~64 callbacks
+    uint32_t peak = 0;     // Since the last Report()
+  };
+
+  // Start the cycle counter and set the deadline: one block at the audio
+  // rate. Call after hw.Init(), before audio starts.
+  void Init(size_t blockSize, float sampleRate);
+
+  // Cycle counter now. Wraps every ~9 s at 480 MHz; deltas stay correct.
+  static uint32_t Now()
+  {
+#if CPU_CYCLE_COUNTER
+    return DWT->CYCCNT;
+#else
+    return 0;
+#endif
+  }
+
+  // Record `cycles` for `stage`. Call from the audio callback only.
+  void Record(Stage stage, uint32_t cycles)
+  {
+#if CPU_PROFILE
+    Stats& stats = mStats[(size_t)stage];
+    stats.current = cycles;
+    // average = 1/64 of the new value + 63/64 of the old, kept in 26.6
+    mAverageQ6[(size_t)stage] += (int32_t)cycles - (int32_t)(mAverageQ6[(size_t)stage] >> 6);
+    stats.average = mAverageQ6[(size_t)stage] >> 6;
+    if (mResetPeaks) {
+      for (Stats& s : mStats)
+        s.peak = 0;
+      mResetPeaks = false;
+    }
+    if (cycles > stats.peak)
+      stats.peak = cycles;
+    if (stage == Stage::Callback && cycles > mDeadline)
+      mOverruns = mOverruns + 1;
+#else
+    (void)stage;
+    (void)cycles;
+#endif
+  }
+
+  Stats Get(Stage stage) const { return mStats[(size_t)stage]; }
+  uint32_t Deadline() const { return mDeadline; }
+  // Callbacks that ran past the deadline since Init().
+  uint32_t Overruns() const { return mOverruns; }
+
+  // Print the stats and load (as a percentage of the deadline) of every
+  // stage with hw.seed.PrintLine(), then restart the peaks. Returns true if
+  // a deadline was missed since the last report. Call from the main loop;
+  // the log must have been started with StartLog().
+  bool Report(daisy::DaisySeed& seed);
+
+private:
+  Stats mStats[(size_t)Stage::Count];
+  uint32_t mAverageQ6[(size_t)Stage::Count] = {};
+  uint32_t mDeadline = 0;
+  volatile uint32_t mOverruns = 0;
+  uint32_t mReportedOverruns = 0;
+  // Set by Report(), cleared by the callback once it has restarted the peaks.
+  volatile bool mResetPeaks = false;
+};
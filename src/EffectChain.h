@@ -0,0 +1,106 @@
+//
+//  EffectChain.h
+//
+//  Static block-processing chain for the mono stages of the signal path,
+//  ahead of the IR manager.
+//
+//  Stages are registered once at setup, in processing order, as plain
+//  function pointers with a context: each call processes a whole block, so
+//  the chain costs one indirect call per stage per block and nothing per
+//  sample. The route is a bitmask of the stages that run. The main loop
+//  sends a new route through the control queue and the audio callback
+//  applies it between blocks with SetRoute(), so a stage is in or out for a
+//  whole block and a bypassed stage isn't called at all. A stage that is
+//  skipped and later runs again is reset first, so it doesn't resume from a
+//  stale state.
+//
+//  Audio side only, apart from AddStage() before audio starts.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Trace.h"
+
+
+template <size_t MaxStages, size_t MaxBlockSize>
+class EffectChain
+{
+  static_assert(MaxStages >= 1 && MaxStages <= 32, "Routes are 32-bit stage masks");
+
+public:
+  // Process one block. `inputs` and `outputs` may alias (the chain runs
+  // every stage after the first in place).
+  typedef void (*ProcessFn)(void* context, const float* inputs, float* outputs, size_t numFrames);
+  // Clear the stage's state before it runs again after being skipped.
+  typedef void (*ResetFn)(void* context);
+
+  // Append a stage. Returns its bit in a route, or 0 when all MaxStages are
+  // taken. It is traced as `event` in TRACE builds (Trace::Event::Count for
+  // none). New stages start out routed.
+  uint32_t AddStage(ProcessFn process, void* context, ResetFn reset = nullptr,
+                    Trace::Event event = Trace::Event::Count)
+  {
+    if (mNumStages >= MaxStages || process == nullptr)
+      return 0;
+    mStages[mNumStages] = {process, context, reset, event};
+    const uint32_t bit = (uint32_t)1 << mNumStages;
+    mNumStages++;
+    mRoute |= bit;
+    mRan |= bit;
+    return bit;
+  }
+
+  // Every stage's bit.
+  uint32_t AllStages() const { return mNumStages == 32 ? ~(uint32_t)0 : ((uint32_t)1 << mNumStages) - 1; }
+
+  // The stages that run from the next block.
+  void SetRoute(uint32_t route) { mRoute = route; }
+  uint32_t Route() const { return mRoute; }
+
+  // Run the routed stages, less any in `skip`, over one block in order.
+  // Returns where the output is: `inputs` itself when no stage ran,
+  // otherwise the chain's scratch buffer, valid until the next call.
+  // numFrames must not exceed MaxBlockSize.
+  const float* Process(const float* inputs, size_t numFrames, uint32_t skip = 0)
+  {
+    const uint32_t active = mRoute & ~skip;
+    const float* from = inputs;
+    for (size_t i = 0; i < mNumStages; i++)
+    {
+      const uint32_t bit = (uint32_t)1 << i;
+      if (!(active & bit))
+        continue;
+      Stage& stage = mStages[i];
+      if (!(mRan & bit) && stage.reset)
+        stage.reset(stage.context);
+      if (stage.event != Trace::Event::Count)
+        Trace::Begin(stage.event);
+      stage.process(stage.context, from, mScratch, numFrames);
+      if (stage.event != Trace::Event::Count)
+        Trace::End(stage.event);
+      from = mScratch;
+    }
+    mRan = active;
+    return from;
+  }
+
+private:
+  struct Stage
+  {
+    ProcessFn process;
+    void* context;
+    ResetFn reset;
+    Trace::Event event;
+  };
+
+  Stage mStages[MaxStages];
+  size_t mNumStages = 0;
+  uint32_t mRoute = 0;
+  // Stages that ran last block.
+  uint32_t mRan = 0;
+  // Every stage after the first works in place here.
+  float mScratch[MaxBlockSize];
+};
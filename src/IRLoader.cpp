@@ -0,0 +1,141 @@
+//
+//  IRLoader.cpp
+//
+//  Asynchronous copy of IR data from memory-mapped QSPI flash into RAM.
+//
+
+#include "IRLoader.h"
+
+#include <algorithm>
+
+
+namespace
+{
+// The one loader serviced by MDMA_IRQHandler.
+IRLoader* activeLoader = nullptr;
+MDMA_HandleTypeDef* activeHandle = nullptr;
+
+constexpr size_t kCacheLine = 32;
+} // namespace
+
+
+extern "C" void MDMA_IRQHandler(void)
+{
+  if (activeHandle != nullptr)
+    HAL_MDMA_IRQHandler(activeHandle);
+}
+
+
+IRLoader::IRLoader()
+{
+}
+
+// Destructor
+IRLoader::~IRLoader()
+{
+    // No Code Needed
+}
+
+
+void IRLoader::Init()
+{
+  __HAL_RCC_MDMA_CLK_ENABLE();
+
+  mHandle.Instance = MDMA_Channel0;
+  mHandle.Init.Request = MDMA_REQUEST_SW;
+  mHandle.Init.TransferTriggerMode = MDMA_BLOCK_TRANSFER;
+  // Lowest priority: audio and everything else on the bus go first.
+  mHandle.Init.Priority = MDMA_PRIORITY_LOW;
+  mHandle.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+  mHandle.Init.SourceInc = MDMA_SRC_INC_WORD;
+  mHandle.Init.DestinationInc = MDMA_DEST_INC_WORD;
+  mHandle.Init.SourceDataSize = MDMA_SRC_DATASIZE_WORD;
+  mHandle.Init.DestDataSize = MDMA_DEST_DATASIZE_WORD;
+  mHandle.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+  mHandle.Init.BufferTransferLength = 128;
+  mHandle.Init.SourceBurst = MDMA_SOURCE_BURST_SINGLE;
+  mHandle.Init.DestBurst = MDMA_DEST_BURST_SINGLE;
+  mHandle.Init.SourceBlockAddressOffset = 0;
+  mHandle.Init.DestBlockAddressOffset = 0;
+  mHandle.Parent = this;
+
+  if (HAL_MDMA_Init(&mHandle) != HAL_OK)
+  {
+    mFailed = true;
+    return;
+  }
+  HAL_MDMA_RegisterCallback(&mHandle, HAL_MDMA_XFER_CPLT_CB_ID, &IRLoader::_TransferComplete);
+  HAL_MDMA_RegisterCallback(&mHandle, HAL_MDMA_XFER_ERROR_CB_ID, &IRLoader::_TransferError);
+
+  activeLoader = this;
+  activeHandle = &mHandle;
+
+  // Below the audio DMA: finishing a load a little later is harmless.
+  HAL_NVIC_SetPriority(MDMA_IRQn, 8, 0);
+  HAL_NVIC_EnableIRQ(MDMA_IRQn);
+}
+
+bool IRLoader::Start(const void* source, void* destination, size_t bytes)
+{
+  if (activeLoader != this || mState != State::Idle || bytes == 0)
+    return false;
+  if ((reinterpret_cast<uintptr_t>(source) & 3) != 0 || (bytes & 3) != 0
+      || (reinterpret_cast<uintptr_t>(destination) & (kCacheLine - 1)) != 0)
+    return false;
+
+  mSource = static_cast<const uint8_t*>(source);
+  mDestination = static_cast<uint8_t*>(destination);
+  mBytes = bytes;
+  mOffset = 0;
+  mFailed = false;
+
+  // Write back and drop any cached destination lines, so an eviction can't
+  // land on top of the DMA'd data.
+  const size_t lines = (bytes + kCacheLine - 1) & ~(kCacheLine - 1);
+  dsy_dma_clear_cache_for_buffer(mDestination, lines);
+  dsy_dma_invalidate_cache_for_buffer(mDestination, lines);
+
+  mState = State::Running;
+  _StartChunk();
+  return true;
+}
+
+bool IRLoader::Poll()
+{
+  if (mState != State::Complete)
+    return false;
+
+  // Anything the CPU speculatively cached during the transfer is stale.
+  dsy_dma_invalidate_cache_for_buffer(mDestination, (mBytes + kCacheLine - 1) & ~(kCacheLine - 1));
+  mState = State::Idle;
+  return true;
+}
+
+void IRLoader::_StartChunk()
+{
+  const size_t chunk = std::min(kChunkBytes, mBytes - mOffset);
+  const uint32_t source = reinterpret_cast<uintptr_t>(mSource + mOffset);
+  const uint32_t destination = reinterpret_cast<uintptr_t>(mDestination + mOffset);
+  mOffset = mOffset + chunk;
+  if (HAL_MDMA_Start_IT(&mHandle, source, destination, (uint32_t)chunk, 1) != HAL_OK)
+  {
+    mFailed = true;
+    mState = State::Complete;
+  }
+}
+
+void IRLoader::_TransferComplete(MDMA_HandleTypeDef* handle)
+{
+  IRLoader* loader = static_cast<IRLoader*>(handle->Parent);
+  if (loader->mOffset < loader->mBytes)
+    loader->_StartChunk();
+  else
+    loader->mState = State::Complete;
+}
+
+void IRLoader::_TransferError(MDMA_HandleTypeDef* handle)
+{
+  IRLoader* loader = static_cast<IRLoader*>(handle->Parent);
+  loader->mFailed = true;
+  loader->mState = State::Complete;
+}
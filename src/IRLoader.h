@@ -0,0 +1,75 @@
+//
+//  IRLoader.h
+//
+//  Asynchronous copy of IR data from memory-mapped QSPI flash into RAM,
+//  using the STM32H7 MDMA.
+//
+//  The transfer runs on a low-priority MDMA channel, so the control loop
+//  (and the LEDs) keep running and the audio DMA wins any bus contention.
+//  Transfers longer than one MDMA block are chained from the completion
+//  interrupt. The destination's cache lines are cleaned before and
+//  invalidated after the transfer, so the CPU never reads stale data.
+//
+//  QSPI must stay memory mapped while a transfer is running: don't save
+//  settings (which erases/writes QSPI) until Busy() is false.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "daisy_seed.h"
+#include "stm32h7xx_hal.h"
+
+
+class IRLoader
+{
+public:
+  IRLoader();
+  ~IRLoader();
+
+  // Set up the MDMA channel and its interrupt. Call once, after hw.Init().
+  void Init();
+
+  // Start copying `bytes` from `source` to `destination`. Both must be
+  // 4-byte aligned; `destination` must start on a 32-byte cache line and own
+  // every line it touches. Returns false (and copies nothing) while a
+  // transfer is running or if the arguments don't qualify.
+  bool Start(const void* source, void* destination, size_t bytes);
+
+  bool Busy() const { return mState == State::Running; }
+
+  // Call from the main loop. Returns true once per finished transfer, after
+  // which the destination is safe to read. A failed transfer also returns
+  // true, with Failed() set.
+  bool Poll();
+  bool Failed() const { return mFailed; }
+
+private:
+  enum class State
+  {
+    Idle,
+    Running,
+    // Set by the interrupt, consumed by Poll().
+    Complete,
+  };
+
+  // Largest chunk handed to the MDMA in one block (its block length limit
+  // is 64 KB).
+  static constexpr size_t kChunkBytes = 32 * 1024;
+
+  void _StartChunk();
+  static void _TransferComplete(MDMA_HandleTypeDef* handle);
+  static void _TransferError(MDMA_HandleTypeDef* handle);
+
+  MDMA_HandleTypeDef mHandle;
+  volatile State mState = State::Idle;
+  volatile bool mFailed = false;
+
+  const uint8_t* mSource = nullptr;
+  uint8_t* mDestination = nullptr;
+  size_t mBytes = 0;
+  // Bytes handed to the MDMA so far; touched by Start() and the interrupt.
+  volatile size_t mOffset = 0;
+};
@@ -0,0 +1,46 @@
+//
+//  BlockFloat.cpp
+//
+//  Decoder for the compressed IR storage format.
+//
+
+#include "BlockFloat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+size_t BlockFloat::PackedBytes(size_t length, int mantissaBits)
+{
+  const size_t blocks = (length + kBlockSize - 1) / kBlockSize;
+  const size_t blockBytes = mantissaBits == 8 ? 1 + kBlockSize : 2 + 2 * kBlockSize;
+  return blocks * blockBytes;
+}
+
+void BlockFloat::Decode(const uint8_t* packed, size_t length, int mantissaBits, float* output)
+{
+  for (size_t start = 0; start < length; start += kBlockSize)
+  {
+    const size_t count = std::min(kBlockSize, length - start);
+    const float scale = std::ldexp(1.0f, (int8_t)packed[0]);
+    float* out = output + start;
+
+    if (mantissaBits == 8)
+    {
+      const int8_t* mantissa = reinterpret_cast<const int8_t*>(packed + 1);
+      for (size_t i = 0; i < count; i++)
+        out[i] = mantissa[i] * scale;
+      packed += 1 + kBlockSize;
+    }
+    else
+    {
+      // The staging buffer keeps blocks 2-byte aligned, but don't rely on it.
+      int16_t mantissa[kBlockSize];
+      std::memcpy(mantissa, packed + 2, sizeof(mantissa));
+      for (size_t i = 0; i < count; i++)
+        out[i] = mantissa[i] * scale;
+      packed += 2 + 2 * kBlockSize;
+    }
+  }
+}
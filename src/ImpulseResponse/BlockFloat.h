@@ -0,0 +1,33 @@
+//
+//  BlockFloat.h
+//
+//  Decoder for the compressed IR storage format written by
+//  wav_to_ir_header.py --compress.
+//
+//  The IR is split into blocks of kBlockSize taps sharing one exponent, with
+//  a signed mantissa per tap: tap = mantissa * 2^exponent. Cab IRs decay
+//  roughly exponentially, so the per-block exponent follows the envelope and
+//  the quiet tail keeps its resolution, unlike a single per-IR scale.
+//
+//  Block layout (little endian), zero padded to whole blocks:
+//    8-bit mantissas:  [int8 exponent][kBlockSize x int8]            17 bytes
+//    16-bit mantissas: [int8 exponent][pad][kBlockSize x int16]      34 bytes
+//  i.e. 8.5 or 17 bits per tap instead of 32.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace BlockFloat
+{
+constexpr size_t kBlockSize = 16;
+
+// Encoded size of `length` taps with 8- or 16-bit mantissas.
+size_t PackedBytes(size_t length, int mantissaBits);
+
+// Expand `length` taps into `output`.
+void Decode(const uint8_t* packed, size_t length, int mantissaBits, float* output);
+} // namespace BlockFloat
@@ -0,0 +1,170 @@
+//
+//  FirKernel.cpp
+//
+//  Direct-form FIR inner loops used by ImpulseResponse.
+//
+
+#include "FirKernel.h"
+
+#include <cstring>
+
+#if IR_KERNEL == IR_KERNEL_CMSIS
+#include "arm_math.h"
+#elif IR_KERNEL == IR_KERNEL_EIGEN
+#include <Eigen/Dense>
+#endif
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+
+#if IR_KERNEL == IR_KERNEL_UNROLLED
+
+const char* FirKernel::Name()
+{
+  return "unrolled";
+}
+
+float FirKernel::Dot(const float* weights, const float* history, size_t numTaps)
+{
+  // Four independent accumulators so consecutive multiply-adds don't wait
+  // on each other's result in the FPU pipeline.
+  float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+  size_t k = 0;
+  for (; k + 4 <= numTaps; k += 4)
+  {
+    acc0 += weights[k] * history[k];
+    acc1 += weights[k + 1] * history[k + 1];
+    acc2 += weights[k + 2] * history[k + 2];
+    acc3 += weights[k + 3] * history[k + 3];
+  }
+  for (; k < numTaps; k++)
+    acc0 += weights[k] * history[k];
+  return (acc0 + acc1) + (acc2 + acc3);
+}
+
+void FirKernel::Convolve(const float* weights, size_t numTaps, const float* history, float* outputs,
+                         size_t numFrames)
+{
+  ConvolveQuads(weights, numTaps, history, outputs, numFrames);
+
+  // Leftover outputs when numFrames isn't a multiple of 4.
+  for (size_t i = numFrames & ~(size_t)3; i < numFrames; i++)
+    outputs[i] = Dot(weights, history + i, numTaps);
+}
+
+#elif IR_KERNEL == IR_KERNEL_CMSIS
+
+const char* FirKernel::Name()
+{
+  return "cmsis";
+}
+
+float FirKernel::Dot(const float* weights, const float* history, size_t numTaps)
+{
+  float32_t result;
+  arm_dot_prod_f32(weights, history, (uint32_t)numTaps, &result);
+  return result;
+}
+
+void FirKernel::Convolve(const float* weights, size_t numTaps, const float* history, float* outputs,
+                         size_t numFrames)
+{
+  // arm_fir_f32 keeps its own copy of the input state and shifts
+  // numTaps - 1 samples down after every block, which for a full-length IR
+  // costs more than it saves; the dot product runs over our history in place.
+  for (size_t i = 0; i < numFrames; i++)
+    arm_dot_prod_f32(weights, history + i, (uint32_t)numTaps, &outputs[i]);
+}
+
+#elif IR_KERNEL == IR_KERNEL_EIGEN
+
+const char* FirKernel::Name()
+{
+  return "eigen";
+}
+
+float FirKernel::Dot(const float* weights, const float* history, size_t numTaps)
+{
+  auto w = Eigen::Map<const Eigen::VectorXf>(weights, numTaps);
+  auto x = Eigen::Map<const Eigen::VectorXf>(history, numTaps);
+  return w.dot(x);
+}
+
+void FirKernel::Convolve(const float* weights, size_t numTaps, const float* history, float* outputs,
+                         size_t numFrames)
+{
+  for (size_t i = 0; i < numFrames; i++)
+    outputs[i] = Dot(weights, history + i, numTaps);
+}
+
+#else
+#error "Unknown IR_KERNEL"
+#endif
+
+
+#if IR_KERNEL == IR_KERNEL_CMSIS
+
+int64_t FirKernel::Dot(const int16_t* weights, const int16_t* history, size_t numTaps)
+{
+  q63_t result;
+  arm_dot_prod_q15(weights, history, (uint32_t)numTaps, &result);
+  return result;
+}
+
+int64_t FirKernel::Dot(const int32_t* weights, const int32_t* history, size_t numTaps)
+{
+  q63_t result;
+  arm_dot_prod_q31(weights, history, (uint32_t)numTaps, &result);
+  return result;
+}
+
+#else
+
+// The unrolled and Eigen backends share the plain C++ fixed-point loops.
+
+int64_t FirKernel::Dot(const int16_t* weights, const int16_t* history, size_t numTaps)
+{
+  int64_t acc0 = 0, acc1 = 0;
+  size_t k = 0;
+#if defined(__ARM_FEATURE_SIMD32)
+  // Two taps per SMLALD. The history window isn't word aligned for every
+  // output, which is fine for single-word loads on the M7.
+  for (; k + 4 <= numTaps; k += 4)
+  {
+    int32_t w0, w1, x0, x1;
+    std::memcpy(&w0, weights + k, sizeof(w0));
+    std::memcpy(&w1, weights + k + 2, sizeof(w1));
+    std::memcpy(&x0, history + k, sizeof(x0));
+    std::memcpy(&x1, history + k + 2, sizeof(x1));
+    acc0 = __smlald(w0, x0, acc0);
+    acc1 = __smlald(w1, x1, acc1);
+  }
+#else
+  for (; k + 2 <= numTaps; k += 2)
+  {
+    acc0 += (int32_t)weights[k] * history[k];
+    acc1 += (int32_t)weights[k + 1] * history[k + 1];
+  }
+#endif
+  for (; k < numTaps; k++)
+    acc0 += (int32_t)weights[k] * history[k];
+  return acc0 + acc1;
+}
+
+int64_t FirKernel::Dot(const int32_t* weights, const int32_t* history, size_t numTaps)
+{
+  int64_t acc0 = 0, acc1 = 0;
+  size_t k = 0;
+  for (; k + 2 <= numTaps; k += 2)
+  {
+    acc0 += ((int64_t)weights[k] * history[k]) >> 14;
+    acc1 += ((int64_t)weights[k + 1] * history[k + 1]) >> 14;
+  }
+  for (; k < numTaps; k++)
+    acc0 += ((int64_t)weights[k] * history[k]) >> 14;
+  return acc0 + acc1;
+}
+
+#endif
@@ -0,0 +1,100 @@
+//
+//  FirKernel.h
+//
+//  Direct-form FIR inner loops used by ImpulseResponse, with the backend
+//  chosen at build time (make IR_KERNEL=unrolled|cmsis|eigen):
+//
+//    IR_KERNEL_UNROLLED  Hand-unrolled, multi-accumulator C++ (default).
+//    IR_KERNEL_CMSIS     CMSIS-DSP arm_dot_prod_f32 per output.
+//    IR_KERNEL_EIGEN     Eigen's generic VectorXf dot (the original path).
+//
+//  Weights are stored time-reversed, so output i is the dot product of the
+//  weights with history[i .. i + numTaps).
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#define IR_KERNEL_UNROLLED 0
+#define IR_KERNEL_CMSIS 1
+#define IR_KERNEL_EIGEN 2
+
+#ifndef IR_KERNEL
+#define IR_KERNEL IR_KERNEL_UNROLLED
+#endif
+
+namespace FirKernel
+{
+// Single output: sum of weights[k] * history[k] for k in [0, numTaps).
+float Dot(const float* weights, const float* history, size_t numTaps);
+
+// `numFrames` outputs; reads numTaps + numFrames - 1 history samples.
+void Convolve(const float* weights, size_t numTaps, const float* history, float* outputs, size_t numFrames);
+
+// Fixed-point dot products into a 64-bit accumulator, so full-length IRs
+// can't overflow.
+// Q15: Q1.15 x Q1.15 products summed exactly, result in Q34.30
+// (dual 16-bit SMLALD on Cortex-M7).
+int64_t Dot(const int16_t* weights, const int16_t* history, size_t numTaps);
+// Q31: each Q1.31 x Q1.31 product truncated to 2.48, result in 16.48
+// (the same format as CMSIS arm_dot_prod_q31).
+int64_t Dot(const int32_t* weights, const int32_t* history, size_t numTaps);
+
+// Backend name, for logging and benchmarks.
+const char* Name();
+
+#if IR_KERNEL == IR_KERNEL_UNROLLED
+// The unrolled Convolve() loop over every whole group of four outputs
+// (numFrames rounded down to a multiple of 4). The counts are size_t for the
+// runtime Convolve() and std::integral_constant for the compile-time one, so
+// the same loop gets constexpr bounds there.
+template <typename TapCount, typename FrameCount>
+inline void ConvolveQuads(const float* weights, TapCount numTaps, const float* history, float* outputs,
+                          FrameCount numFrames)
+{
+  for (size_t i = 0; i + 4 <= numFrames; i += 4)
+  {
+    // Register blocking: each weight is loaded once for four outputs, and the
+    // input window slides through registers so only one new sample is loaded
+    // per tap.
+    const float* x = history + i;
+    float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+    float x0 = x[0], x1 = x[1], x2 = x[2];
+    for (size_t k = 0; k < numTaps; k++)
+    {
+      const float x3 = x[k + 3];
+      const float wk = weights[k];
+      acc0 += wk * x0;
+      acc1 += wk * x1;
+      acc2 += wk * x2;
+      acc3 += wk * x3;
+      x0 = x1;
+      x1 = x2;
+      x2 = x3;
+    }
+    outputs[i] = acc0;
+    outputs[i + 1] = acc1;
+    outputs[i + 2] = acc2;
+    outputs[i + 3] = acc3;
+  }
+}
+#endif
+
+// Compile-time sized Convolve() for StaticImpulseResponse. With constexpr
+// bounds the compiler can fully unroll the frame loop and keep all the
+// accumulators in registers. Other backends use their runtime loop.
+template <size_t NumTaps, size_t NumFrames>
+inline void Convolve(const float* weights, const float* history, float* outputs)
+{
+#if IR_KERNEL == IR_KERNEL_UNROLLED
+  static_assert(NumFrames % 4 == 0, "NumFrames must be a multiple of 4");
+  ConvolveQuads(weights, std::integral_constant<size_t, NumTaps>(), history, outputs,
+                std::integral_constant<size_t, NumFrames>());
+#else
+  Convolve(weights, NumTaps, history, outputs, NumFrames);
+#endif
+}
+} // namespace FirKernel
@@ -0,0 +1,160 @@
+//
+//  FixedPointFir.cpp
+//
+//  Q15 / Q31 direct-form convolution.
+//
+
+#include "FixedPointFir.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FirKernel.h"
+
+
+namespace
+{
+// Per-format constants: fractional bits of a sample, fractional bits of the
+// FirKernel::Dot() result, and the saturation limits as floats.
+template <typename Sample>
+struct Format;
+
+template <>
+struct Format<int16_t>
+{
+  static constexpr int kFracBits = 15;
+  static constexpr int kAccumulatorFracBits = 30;
+  static constexpr float kMax = 32767.0f;
+  static constexpr float kMin = -32768.0f;
+};
+
+template <>
+struct Format<int32_t>
+{
+  static constexpr int kFracBits = 31;
+  static constexpr int kAccumulatorFracBits = 48;
+  // Largest float below 2^31.
+  static constexpr float kMax = 2147483520.0f;
+  static constexpr float kMin = -2147483648.0f;
+};
+} // namespace
+
+
+template <typename Sample>
+const int FixedPointFir<Sample>::kFracBits = Format<Sample>::kFracBits;
+
+template <typename Sample>
+FixedPointFir<Sample>::FixedPointFir()
+{
+}
+
+// Destructor
+template <typename Sample>
+FixedPointFir<Sample>::~FixedPointFir()
+{
+    // No Code Needed
+}
+
+
+template <typename Sample>
+int FixedPointFir<Sample>::WeightShift(const float* irData, size_t irLength)
+{
+  float peak = 0.0f;
+  for (size_t i = 0; i < irLength; i++)
+    peak = std::max(peak, std::fabs(irData[i]));
+  if (peak == 0.0f)
+    return 0;
+  int exponent;
+  std::frexp(peak, &exponent); // peak = m * 2^exponent, m in [0.5, 1)
+  return -exponent;
+}
+
+template <typename Sample>
+void FixedPointFir<Sample>::Init(const float* irData, size_t irLength, int headroomBits, HistoryMode mode,
+                                 size_t maxBlockSize)
+{
+  const int weightShift = WeightShift(irData, irLength);
+  const float scale = std::ldexp(1.0f, kFracBits + weightShift);
+
+  // Local copies: std::min/max take references, which would odr-use the
+  // constexpr members (needing out-of-line definitions before C++17).
+  const float lo = Format<Sample>::kMin;
+  const float hi = Format<Sample>::kMax;
+  mWeight.resize(irLength);
+  for (size_t i = 0, j = irLength - 1; i < irLength; i++, j--)
+  {
+    const float q = std::round(irData[i] * scale);
+    mWeight[j] = (Sample)std::min(std::max(q, lo), hi);
+  }
+  _Configure(irLength, weightShift, headroomBits, mode, maxBlockSize);
+}
+
+template <typename Sample>
+void FixedPointFir<Sample>::Init(const Sample* irData, size_t irLength, int weightShift, int headroomBits,
+                                 HistoryMode mode, size_t maxBlockSize)
+{
+  mWeight.resize(irLength);
+  for (size_t i = 0, j = irLength - 1; i < irLength; i++, j--)
+    mWeight[j] = irData[i];
+  _Configure(irLength, weightShift, headroomBits, mode, maxBlockSize);
+}
+
+template <typename Sample>
+void FixedPointFir<Sample>::_Configure(size_t irLength, int weightShift, int headroomBits, HistoryMode mode,
+                                       size_t maxBlockSize)
+{
+  mInputScale = std::ldexp(1.0f, kFracBits - headroomBits);
+  mOutputScale = std::ldexp(1.0f, headroomBits - Format<Sample>::kAccumulatorFracBits - weightShift);
+  mClipCount = 0;
+  mBlockScratch.assign(std::max<size_t>(maxBlockSize, 1), Sample(0));
+  this->_ResetHistory(irLength - 1, mode, maxBlockSize);
+}
+
+template <typename Sample>
+Sample FixedPointFir<Sample>::_Quantize(float input)
+{
+  float q = input * mInputScale;
+  if (q > Format<Sample>::kMax)
+  {
+    q = Format<Sample>::kMax;
+    mClipCount++;
+  }
+  else if (q < Format<Sample>::kMin)
+  {
+    q = Format<Sample>::kMin;
+    mClipCount++;
+  }
+  return (Sample)(q + (q >= 0.0f ? 0.5f : -0.5f));
+}
+
+template <typename Sample>
+float FixedPointFir<Sample>::Process(float input)
+{
+  this->_UpdateHistory(_Quantize(input));
+  const int64_t acc = FirKernel::Dot(mWeight.data(), this->_HistoryWindow(), mWeight.size());
+  this->_AdvanceHistoryIndex(1);
+  return (float)acc * mOutputScale;
+}
+
+template <typename Sample>
+void FixedPointFir<Sample>::ProcessBlock(const float* inputs, float* outputs, size_t numFrames)
+{
+  const size_t maxBlock = std::min(this->_MaxHistoryBlock(), mBlockScratch.size());
+  for (size_t done = 0; done < numFrames;)
+  {
+    const size_t n = std::min(numFrames - done, maxBlock);
+    for (size_t i = 0; i < n; i++)
+      mBlockScratch[i] = _Quantize(inputs[done + i]);
+    this->_UpdateHistory(mBlockScratch.data(), n);
+
+    const Sample* window = this->_HistoryWindow();
+    for (size_t i = 0; i < n; i++)
+      outputs[done + i] = (float)FirKernel::Dot(mWeight.data(), window + i, mWeight.size()) * mOutputScale;
+
+    this->_AdvanceHistoryIndex(n);
+    done += n;
+  }
+}
+
+template class FixedPointFir<int16_t>;
+template class FixedPointFir<int32_t>;
@@ -0,0 +1,67 @@
+//
+//  FixedPointFir.h
+//
+//  Q15 / Q31 direct-form convolution, for the fixed-point ImpulseResponse
+//  precisions. Halves (Q15) the weight and history memory traffic of the
+//  float path and lets the Cortex-M7 use its dual 16-bit MAC.
+//
+//  Scaling:
+//  * Weights are normalised per IR so the largest tap uses the full range:
+//    weight = q * 2^-(kFracBits + weightShift).
+//  * Inputs are scaled down by 2^headroomBits before quantisation, so input
+//    peaks up to 2^headroomBits (e.g. after the bass boost) don't clip.
+//    Anything beyond that saturates and is counted in ClipCount().
+//  * Products accumulate in 64 bits, so the sum itself never overflows.
+//
+
+#pragma once
+
+#include <cstdint>
+#include "IRMemory.h"
+#include "dsp.h"
+
+
+template <typename Sample>
+class FixedPointFir : public HistoryT<Sample>
+{
+public:
+  // Fractional bits of a weight or input sample (15 or 31).
+  static const int kFracBits;
+
+  FixedPointFir();
+  ~FixedPointFir();
+
+  // Shift that normalises the largest |tap| of a float IR into [0.5, 1).
+  static int WeightShift(const float* irData, size_t irLength);
+
+  // Quantise a float IR (natural order).
+  void Init(const float* irData, size_t irLength, int headroomBits, HistoryMode mode, size_t maxBlockSize);
+  // Use an IR that was quantised offline (natural order), where
+  // weight = irData[i] * 2^-(kFracBits + weightShift).
+  void Init(const Sample* irData, size_t irLength, int weightShift, int headroomBits, HistoryMode mode,
+            size_t maxBlockSize);
+
+  // Clear the history, keeping the IR.
+  void Reset() { this->_ClearHistory(); }
+
+  float Process(float input);
+  // `inputs` and `outputs` may alias.
+  void ProcessBlock(const float* inputs, float* outputs, size_t numFrames);
+
+  // Input samples that saturated since Init().
+  uint32_t ClipCount() const { return mClipCount; }
+
+private:
+  // Set the scale factors and clear the history once mWeight is filled.
+  void _Configure(size_t irLength, int weightShift, int headroomBits, HistoryMode mode, size_t maxBlockSize);
+  // Float input -> saturated fixed-point sample.
+  Sample _Quantize(float input);
+
+  // Time-reversed weights.
+  IRMemory::Vector<Sample, IRMemory::Use::Weights> mWeight;
+  // Quantised inputs for one block, before they go into the history.
+  IRMemory::Vector<Sample, IRMemory::Use::Scratch> mBlockScratch;
+  float mInputScale = 1.0f;
+  float mOutputScale = 1.0f;
+  uint32_t mClipCount = 0;
+};
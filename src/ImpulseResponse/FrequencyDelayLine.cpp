@@ -0,0 +1,117 @@
+//
+//  FrequencyDelayLine.cpp
+//
+//  The input side of uniformly partitioned overlap-save convolution.
+//
+
+#include "FrequencyDelayLine.h"
+
+#include <algorithm>
+
+
+FrequencyDelayLine::FrequencyDelayLine()
+{
+}
+
+// Destructor
+FrequencyDelayLine::~FrequencyDelayLine()
+{
+    // No Code Needed
+}
+
+
+void FrequencyDelayLine::Init(size_t partitionSize, size_t numPartitions)
+{
+  mPartitionSize = partitionSize;
+  mNumPartitions = std::max<size_t>(1, numPartitions);
+
+  const size_t fftSize = 2 * partitionSize;
+  mFFT.Init(fftSize);
+  mNumBins = mFFT.NumBins();
+
+  mInputWindow.assign(fftSize, 0.0f);
+  mTimeScratch.assign(fftSize, 0.0f);
+  mRing.assign(mNumPartitions * mNumBins, std::complex<float>(0.0f, 0.0f));
+  mIndex = 0;
+}
+
+void FrequencyDelayLine::TransformIR(const float* irData, size_t irLength, std::complex<float>* spectra)
+{
+  const float scale = 1.0f / (float)mFFT.Size();
+  const size_t numPartitions = NumPartitions(irLength, mPartitionSize);
+  for (size_t p = 0; p < numPartitions; p++)
+  {
+    std::fill(mTimeScratch.begin(), mTimeScratch.end(), 0.0f);
+    const size_t start = p * mPartitionSize;
+    const size_t count = std::min(mPartitionSize, irLength - std::min(irLength, start));
+    for (size_t i = 0; i < count; i++)
+      mTimeScratch[i] = irData[start + i] * scale;
+    mFFT.Forward(mTimeScratch.data(), &spectra[p * mNumBins]);
+  }
+  // Nothing has been processed yet: Output() reads as silence.
+  std::fill(mTimeScratch.begin(), mTimeScratch.end(), 0.0f);
+}
+
+void FrequencyDelayLine::Reset()
+{
+  std::fill(mInputWindow.begin(), mInputWindow.end(), 0.0f);
+  std::fill(mTimeScratch.begin(), mTimeScratch.end(), 0.0f);
+  std::fill(mRing.begin(), mRing.end(), std::complex<float>(0.0f, 0.0f));
+  mIndex = 0;
+}
+
+void FrequencyDelayLine::Push(const float* input)
+{
+  const size_t B = mPartitionSize;
+  std::copy(mInputWindow.begin() + B, mInputWindow.end(), mInputWindow.begin());
+  std::copy(input, input + B, mInputWindow.begin() + B);
+}
+
+void FrequencyDelayLine::ForwardStep(size_t step)
+{
+  if (step == 0)
+    mFFT.BeginForward(mInputWindow.data());
+  else if (step < FFTSteps() - 1)
+    mFFT.Pass(step - 1, false);
+  else
+    mFFT.EndForward(&mRing[mIndex * mNumBins]);
+}
+
+void FrequencyDelayLine::Forward()
+{
+  mFFT.Forward(mInputWindow.data(), &mRing[mIndex * mNumBins]);
+}
+
+void FrequencyDelayLine::Accumulate(std::complex<float>* acc, const std::complex<float>* irSpectra, size_t first,
+                                    size_t count) const
+{
+  // Partition p pairs with the input spectrum p blocks back from the newest.
+  size_t slot = mIndex >= first ? mIndex - first : mIndex + mNumPartitions - first;
+  float* a = reinterpret_cast<float*>(acc);
+  for (size_t p = first; p < first + count; p++)
+  {
+    const float* x = reinterpret_cast<const float*>(&mRing[slot * mNumBins]);
+    const float* h = reinterpret_cast<const float*>(&irSpectra[p * mNumBins]);
+    for (size_t b = 0; b < 2 * mNumBins; b += 2)
+    {
+      a[b] += x[b] * h[b] - x[b + 1] * h[b + 1];
+      a[b + 1] += x[b] * h[b + 1] + x[b + 1] * h[b];
+    }
+    slot = (slot == 0) ? mNumPartitions - 1 : slot - 1;
+  }
+}
+
+void FrequencyDelayLine::InverseStep(size_t step, const std::complex<float>* spectrum)
+{
+  if (step == 0)
+    mFFT.BeginInverse(spectrum);
+  else if (step < FFTSteps() - 1)
+    mFFT.Pass(step - 1, true);
+  else
+    mFFT.EndInverse(mTimeScratch.data());
+}
+
+void FrequencyDelayLine::Inverse(const std::complex<float>* spectrum)
+{
+  mFFT.Inverse(spectrum, mTimeScratch.data());
+}
@@ -0,0 +1,95 @@
+//
+//  FrequencyDelayLine.h
+//
+//  The input side of uniformly partitioned overlap-save (UPOLS)
+//  convolution, shared by PartitionedConvolver and MultiIRConvolver.
+//
+//  Every block, the last two input blocks are transformed once and pushed
+//  into a ring of input spectra. An IR, split into partitions of one block
+//  and transformed the same way (TransformIR()), is convolved by
+//  multiplying each partition spectrum with the input spectrum as many
+//  blocks old and summing (Accumulate()). One inverse transform of the sum
+//  yields the block of output.
+//
+//  Both transforms can run in FFTSteps() pieces (see RealFFT), so a large
+//  partition can be spread over several audio callbacks.
+//
+
+#pragma once
+
+#include <complex>
+
+#include "IRMemory.h"
+#include "RealFFT.h"
+
+
+class FrequencyDelayLine
+{
+public:
+  FrequencyDelayLine();
+  ~FrequencyDelayLine();
+
+  // Size the FFT for `partitionSize` (a power of two) and the ring for
+  // `numPartitions` input spectra, and clear all state.
+  void Init(size_t partitionSize, size_t numPartitions);
+  // Partitions needed to cover `irLength` taps, at least one.
+  static size_t NumPartitions(size_t irLength, size_t partitionSize)
+  {
+    const size_t partitions = (irLength + partitionSize - 1) / partitionSize;
+    return partitions > 0 ? partitions : 1;
+  }
+  // Transform irData[0, irLength) into NumPartitions() x NumBins() partition
+  // spectra, each zero padded to the FFT size. The 1/N of the unnormalised
+  // inverse transform is folded in here so output doesn't pay for it.
+  void TransformIR(const float* irData, size_t irLength, std::complex<float>* spectra);
+
+  // Clear the input, ring and output, keeping the sizes.
+  void Reset();
+
+  // Slide PartitionSize() samples into the overlap-save window:
+  // [previous block | current block].
+  void Push(const float* input);
+
+  // Transform the window into the newest ring slot, in FFTSteps() calls
+  // with step 0, 1, ...; Forward() runs them all.
+  size_t FFTSteps() const { return mFFT.NumPasses() + 2; }
+  void ForwardStep(size_t step);
+  void Forward();
+
+  // acc += the IR partitions [first, first + count) times the input spectra
+  // first, first + 1, ... blocks older than the newest. `irSpectra` is in
+  // TransformIR() layout.
+  void Accumulate(std::complex<float>* acc, const std::complex<float>* irSpectra, size_t first, size_t count) const;
+
+  // Inverse transform of `spectrum` into Output(), likewise in FFTSteps()
+  // calls; Inverse() runs them all. Only step 0 reads `spectrum`.
+  void InverseStep(size_t step, const std::complex<float>* spectrum);
+  void Inverse(const std::complex<float>* spectrum);
+  // Overlap-save: the first half of the inverse is circular wrap-around,
+  // this points at the second, PartitionSize() samples.
+  const float* Output() const { return &mTimeScratch[mPartitionSize]; }
+
+  // Move on to the next ring slot, once every Accumulate() for this block
+  // is done.
+  void Advance() { mIndex = (mIndex + 1 == mNumPartitions) ? 0 : mIndex + 1; }
+
+  size_t PartitionSize() const { return mPartitionSize; }
+  size_t NumPartitions() const { return mNumPartitions; }
+  size_t NumBins() const { return mNumBins; }
+
+private:
+  size_t mPartitionSize = 0;
+  size_t mNumPartitions = 0;
+  size_t mNumBins = 0;
+
+  RealFFT mFFT;
+
+  // Last two input blocks, oldest first (the overlap-save window).
+  IRMemory::Vector<float, IRMemory::Use::History> mInputWindow;
+  // Time-domain scratch for the transforms.
+  IRMemory::Vector<float, IRMemory::Use::Scratch> mTimeScratch;
+  // Ring of input spectra, mNumPartitions x mNumBins.
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::History> mRing;
+  // Slot of the most recent input spectrum in mRing.
+  size_t mIndex = 0;
+};
@@ -0,0 +1,79 @@
+//
+//  IRCache.cpp
+//
+//  Cache of IRs in the engine's native format.
+//
+
+#include "IRCache.h"
+
+
+IRCache::IRCache()
+{
+}
+
+// Destructor
+IRCache::~IRCache()
+{
+    // No Code Needed
+}
+
+
+void IRCache::Init(void* memory, size_t bytes)
+{
+  // Align the arena itself; entry sizes are rounded to keep it aligned.
+  uint8_t* start = static_cast<uint8_t*>(memory);
+  const size_t skip = (kAlignment - (reinterpret_cast<uintptr_t>(start) & (kAlignment - 1))) & (kAlignment - 1);
+  mMemory = start + skip;
+  mCapacity = bytes > skip ? bytes - skip : 0;
+  Clear();
+}
+
+void IRCache::Clear()
+{
+  mUsed = 0;
+  for (Entry& entry : mEntries)
+    entry = Entry();
+}
+
+void IRCache::Invalidate(size_t index)
+{
+  if (index < kMaxEntries && !mEntries[index].reserved)
+    mEntries[index].valid = false;
+}
+
+const void* IRCache::Find(size_t index) const
+{
+  if (index >= kMaxEntries || !mEntries[index].valid)
+    return nullptr;
+  return mEntries[index].data;
+}
+
+void* IRCache::Reserve(size_t index, size_t bytes)
+{
+  const size_t rounded = (bytes + kAlignment - 1) & ~(kAlignment - 1);
+  if (index >= kMaxEntries || Contains(index) || rounded == 0)
+    return nullptr;
+
+  // A stale entry's space is reused when the new form fits in it.
+  Entry& entry = mEntries[index];
+  if (entry.data == nullptr || rounded > entry.bytes)
+  {
+    if (rounded > mCapacity - mUsed)
+      return nullptr;
+    entry.data = mMemory + mUsed;
+    entry.bytes = rounded;
+    mUsed += rounded;
+  }
+  entry.reserved = true;
+  entry.valid = false;
+  return entry.data;
+}
+
+void IRCache::Commit(size_t index)
+{
+  if (index < kMaxEntries && mEntries[index].reserved)
+  {
+    mEntries[index].reserved = false;
+    mEntries[index].valid = true;
+  }
+}
@@ -0,0 +1,74 @@
+//
+//  IRCache.h
+//
+//  Cache of IRs in the form the engine initialises from (float taps, Q15/Q31
+//  taps or partition spectra), kept in a large memory such as the Daisy's
+//  SDRAM. Once an IR is cached, switching to it no longer touches QSPI or
+//  decodes anything: ImpulseResponse::Init() reads straight from the entry
+//  and copies into its own buffers, which the IRMemory placement map puts in
+//  internal SRAM.
+//
+//  Entries are bump allocated and never evicted: the compiled IR set is
+//  fixed, so the cache either holds all of it or stops admitting new IRs.
+//  An entry whose form goes stale (Invalidate()) keeps its space for the
+//  same IR's next Reserve() if that fits, and is otherwise left behind.
+//  Control side only, like IRManager::BeginLoad().
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+class IRCache
+{
+public:
+  // Upper bound on cached IRs (three banks of 12).
+  static constexpr size_t kMaxEntries = 36;
+  // Entry alignment: one cache line, so the MDMA can write entries directly.
+  static constexpr size_t kAlignment = 32;
+
+  IRCache();
+  ~IRCache();
+
+  // Use `bytes` at `memory` for the entries and forget everything cached.
+  void Init(void* memory, size_t bytes);
+  // Forget everything cached.
+  void Clear();
+  // Forget IR `index`'s cached copy, e.g. when its native form changes with
+  // the audio block size. A reservation being filled is left alone.
+  void Invalidate(size_t index);
+
+  // Cached copy of IR `index`, or nullptr.
+  const void* Find(size_t index) const;
+  // Space for IR `index`'s `bytes`, to be filled and then Commit()ted.
+  // Returns nullptr if the IR is already cached or reserved, or doesn't fit.
+  void* Reserve(size_t index, size_t bytes);
+  // The reserved entry now holds valid data.
+  void Commit(size_t index);
+
+  // True if IR `index` is cached or being filled.
+  bool Contains(size_t index) const
+  {
+    return index < kMaxEntries && (mEntries[index].reserved || mEntries[index].valid);
+  }
+  // Bytes of the arena allocated so far, and its size.
+  size_t Used() const { return mUsed; }
+  size_t Capacity() const { return mCapacity; }
+
+private:
+  struct Entry
+  {
+    // Space allocated to the IR, kept across Invalidate().
+    uint8_t* data = nullptr;
+    size_t bytes = 0;
+    bool reserved = false;
+    bool valid = false;
+  };
+
+  uint8_t* mMemory = nullptr;
+  size_t mCapacity = 0;
+  size_t mUsed = 0;
+  Entry mEntries[kMaxEntries];
+};
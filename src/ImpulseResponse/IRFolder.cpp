@@ -0,0 +1,51 @@
+//
+//  IRFolder.cpp
+//
+//  Folds a linear stage into an IR by incremental convolution.
+//
+
+#include "IRFolder.h"
+
+#include <algorithm>
+
+
+IRFolder::IRFolder()
+{
+}
+
+// Destructor
+IRFolder::~IRFolder()
+{
+    // No Code Needed
+}
+
+
+void IRFolder::Init(const float* ir, size_t irLength, const float* stage, size_t stageLength, float* output,
+                    size_t maxLength)
+{
+  mIR = ir;
+  mIRLength = irLength;
+  mStage = stage;
+  mStageLength = stageLength;
+  mOutput = output;
+  mLength = (irLength == 0 || stageLength == 0) ? 0 : std::min(irLength + stageLength - 1, maxLength);
+  mPosition = 0;
+}
+
+bool IRFolder::Step(size_t macs)
+{
+  const size_t taps = std::max<size_t>(1, macs / std::max<size_t>(1, std::min(mIRLength, mStageLength)));
+  const size_t end = std::min(mPosition + taps, mLength);
+  for (size_t n = mPosition; n < end; n++)
+  {
+    // output[n] = sum of ir[n - k] * stage[k] over the overlap
+    const size_t first = n >= mIRLength ? n - mIRLength + 1 : 0;
+    const size_t last = std::min(n + 1, mStageLength);
+    float sum = 0.0f;
+    for (size_t k = first; k < last; k++)
+      sum += mIR[n - k] * mStage[k];
+    mOutput[n] = sum;
+  }
+  mPosition = end;
+  return Done();
+}
@@ -0,0 +1,44 @@
+//
+//  IRFolder.h
+//
+//  Folds a linear, time-invariant stage into an IR: convolves the IR with
+//  the stage's impulse response, so a slot loaded with the result runs the
+//  stage for free. The convolution is time-domain and incremental, so the
+//  control loop can spread it over many passes with a bounded cost each.
+//
+
+#pragma once
+
+#include <cstddef>
+
+
+class IRFolder
+{
+public:
+  IRFolder();
+  ~IRFolder();
+
+  // Set up folding `stage` into `ir`, into `output`, which holds up to
+  // `maxLength` taps (the result is truncated there). All three buffers
+  // are owned by the caller and must stay valid until Done().
+  void Init(const float* ir, size_t irLength, const float* stage, size_t stageLength, float* output,
+            size_t maxLength);
+
+  // Compute output taps for about `macs` multiply-accumulates (at least
+  // one tap). Returns true once every tap is done.
+  bool Step(size_t macs);
+
+  bool Done() const { return mPosition == mLength; }
+  // Taps in the folded IR.
+  size_t Length() const { return mLength; }
+
+private:
+  const float* mIR = nullptr;
+  size_t mIRLength = 0;
+  const float* mStage = nullptr;
+  size_t mStageLength = 0;
+  float* mOutput = nullptr;
+  size_t mLength = 0;
+  // Next output tap to compute.
+  size_t mPosition = 0;
+};
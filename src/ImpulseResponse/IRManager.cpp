@@ -0,0 +1,162 @@
+//
+//  IRManager.cpp
+//
+//  Double-buffered IR slots with click-free switching.
+//
+
+#include "IRManager.h"
+
+#include "Trace.h"
+
+#include <algorithm>
+
+
+IRManager::IRManager()
+{
+}
+
+// Destructor
+IRManager::~IRManager()
+{
+    // No Code Needed
+}
+
+
+void IRManager::Init(size_t maxBlockSize, size_t fadeBlocks)
+{
+  mFadeBlocks = fadeBlocks;
+  mFadeScratch.assign(maxBlockSize, 0.0f);
+  mFadeScratchRight.assign(maxBlockSize, 0.0f);
+  mSlots[0].bypass = true;
+  mSlots[1].bypass = true;
+  mSlots[0].folded = false;
+  mSlots[1].folded = false;
+  mActive = 0;
+  mFadePosition = 0;
+  mFadeLength = 0;
+  mTailLength = 0;
+  mBlockFading = false;
+  mState.store(State::Idle, std::memory_order_release);
+}
+
+ImpulseResponse* IRManager::BeginLoad()
+{
+  if (mState.load(std::memory_order_acquire) != State::Idle)
+    return nullptr;
+  mState.store(State::Loading, std::memory_order_relaxed);
+  return &mSlots[mActive ^ 1].ir;
+}
+
+void IRManager::CommitLoad(bool bypass, bool folded)
+{
+  mSlots[mActive ^ 1].bypass = bypass;
+  mSlots[mActive ^ 1].folded = folded && !bypass;
+  // Publishes the slot contents to the audio side.
+  mState.store(State::Ready, std::memory_order_release);
+}
+
+bool IRManager::CommitBypass()
+{
+  if (BeginLoad() == nullptr)
+    return false;
+  CommitLoad(true);
+  return true;
+}
+
+void IRManager::ProcessBlock(const float* inputs, float* outputs, size_t numFrames)
+{
+  ProcessBlock(inputs, outputs, nullptr, numFrames);
+}
+
+void IRManager::ProcessBlock(const float* inputs, float* left, float* right, size_t numFrames)
+{
+  BeginBlock(numFrames);
+  ProcessBlock(inputs, inputs, left, right, numFrames);
+}
+
+bool IRManager::BeginBlock(size_t numFrames)
+{
+  State state = mState.load(std::memory_order_acquire);
+  if (state == State::Ready)
+  {
+    mActive ^= 1;
+    mFadePosition = 0;
+    mFadeLength = std::max<size_t>(mFadeBlocks * numFrames, 1);
+    const Slot& outgoing = mSlots[mActive ^ 1];
+    mTailLength = outgoing.bypass ? 0 : std::min(outgoing.ir.TailLength(), mFadeLength);
+    state = State::Fading;
+    mState.store(state, std::memory_order_release);
+    Trace::Mark(Trace::Event::IrSwap);
+  }
+  mBlockFading = state == State::Fading;
+  // Once the input has faded out of it, the outgoing slot only hears silence.
+  const bool outgoingListening = mBlockFading && mFadePosition < mFadeLength;
+  return !mSlots[mActive].folded || (outgoingListening && !mSlots[mActive ^ 1].folded);
+}
+
+void IRManager::ProcessBlock(const float* dryInputs, const float* stagedInputs, float* left, float* right,
+                             size_t numFrames)
+{
+  Slot& current = mSlots[mActive];
+  if (!mBlockFading)
+  {
+    _ProcessSlot(current, current.folded ? dryInputs : stagedInputs, left, right, numFrames);
+    return;
+  }
+
+  // The slots' inputs are crossfaded, not their outputs, and the two
+  // outputs summed. Linear (equal gain): both see the same signal.
+  Slot& outgoing = mSlots[mActive ^ 1];
+  const float* outgoingInputs = outgoing.folded ? dryInputs : stagedInputs;
+  const float* currentInputs = current.folded ? dryInputs : stagedInputs;
+  float* previousLeft = mFadeScratch.data();
+  float* previousRight = right ? mFadeScratchRight.data() : nullptr;
+  if (mFadePosition < mFadeLength)
+  {
+    // Both inputs are read before `left`, which may alias either, is written.
+    const float step = 1.0f / (float)mFadeLength;
+    for (size_t i = 0; i < numFrames; i++)
+    {
+      const float gain = std::min((float)(mFadePosition + i + 1) * step, 1.0f);
+      previousLeft[i] = (1.0f - gain) * outgoingInputs[i];
+      left[i] = gain * currentInputs[i];
+    }
+    currentInputs = left;
+  }
+  else
+  {
+    std::fill(previousLeft, previousLeft + numFrames, 0.0f);
+  }
+  _ProcessSlot(outgoing, previousLeft, previousLeft, previousRight, numFrames);
+  _ProcessSlot(current, currentInputs, left, right, numFrames);
+  // Past the input fade the outgoing output fades to zero over mTailLength
+  const float tailStep = mTailLength > 0 ? 1.0f / (float)mTailLength : 1.0f;
+  for (size_t i = 0; i < numFrames; i++)
+  {
+    const size_t position = mFadePosition + i;
+    const float gain =
+      position < mFadeLength ? 1.0f : std::max(1.0f - (float)(position - mFadeLength + 1) * tailStep, 0.0f);
+    left[i] += gain * previousLeft[i];
+    if (right)
+      right[i] += gain * previousRight[i];
+  }
+
+  mFadePosition += numFrames;
+  const bool rungOut = mFadePosition >= mFadeLength + mTailLength || outgoing.bypass || outgoing.ir.Idle();
+  if (mFadePosition >= mFadeLength && rungOut)
+    mState.store(State::Idle, std::memory_order_release);
+}
+
+void IRManager::_ProcessSlot(Slot& slot, const float* inputs, float* left, float* right, size_t numFrames)
+{
+  if (slot.bypass)
+  {
+    if (left != inputs)
+      std::copy(inputs, inputs + numFrames, left);
+    if (right)
+      std::copy(inputs, inputs + numFrames, right);
+    return;
+  }
+  slot.ir.SetBlend(mBlend);
+  slot.ir.ProcessBlock(inputs, left, right, numFrames);
+}
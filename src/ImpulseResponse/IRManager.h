@@ -0,0 +1,148 @@
+//
+//  IRManager.h
+//
+//  Double-buffered IR slots with click-free switching.
+//
+//  The control side (main loop) prepares the next IR in the inactive slot
+//  while the audio side keeps convolving with the active one. Once the new
+//  slot is committed, the audio side swaps slots at the start of its next
+//  block and crossfades the input from the old slot to the new one over a
+//  configurable number of blocks. Each slot keeps its own history: the new
+//  one builds up its tail from the fade-in, and the old one keeps running on
+//  silence for one more fade length while its output fades to zero, so its
+//  tail decays instead of being cut off. It stops sooner if the tail ends
+//  first (TailLength()) or its idle gate finds nothing left. Either way a
+//  switch runs both IRs for at most two fade lengths, and the callback
+//  needs the headroom for that.
+//
+//  A slot can hold an IR with earlier linear stages of the signal chain
+//  folded in (IRFolder). Such a slot reads the signal from before those
+//  stages; the audio side runs them only while some slot still needs them.
+//
+//  Threading: BeginLoad()/Commit*() from one non-interrupt context only;
+//  BeginBlock()/ProcessBlock() from the audio callback only. All setup, including every
+//  allocation in ImpulseResponse::Init(), happens on the control side.
+//
+
+#pragma once
+
+#include <atomic>
+
+#include "IRMemory.h"
+#include "ImpulseResponse.h"
+
+
+class IRManager
+{
+public:
+  IRManager();
+  ~IRManager();
+
+  // Both slots start out bypassed (dry).
+  void Init(size_t maxBlockSize, size_t fadeBlocks);
+  void SetFadeBlocks(size_t fadeBlocks) { mFadeBlocks = fadeBlocks; }
+  // Idle gate level for both slots (ImpulseResponse::SetSilenceThreshold()).
+  // Before audio starts only.
+  void SetSilenceThreshold(float threshold)
+  {
+    mSlots[0].ir.SetSilenceThreshold(threshold);
+    mSlots[1].ir.SetSilenceThreshold(threshold);
+  }
+
+  // --- Control side ---
+
+  // Claim the inactive slot for setup. Returns nullptr while the previous
+  // switch is still pending or fading; try again on a later pass.
+  ImpulseResponse* BeginLoad();
+  // Hand the slot claimed by BeginLoad() to the audio side. It goes live at
+  // the start of the next audio block. With `bypass`, the slot passes audio
+  // through dry instead of convolving. With `folded`, its IR already
+  // contains the folded stages (see the ProcessBlock() taking two inputs).
+  void CommitLoad(bool bypass = false, bool folded = false);
+  // Crossfade to dry. Returns false (and does nothing) while busy.
+  bool CommitBypass();
+  // True from BeginLoad() until the crossfade has finished and the old
+  // slot has rung out.
+  bool Busy() const { return mState.load(std::memory_order_acquire) != State::Idle; }
+
+  // --- Audio side ---
+
+  // `inputs` and `outputs` may alias. numFrames must not exceed the
+  // maxBlockSize given to Init().
+  void ProcessBlock(const float* inputs, float* outputs, size_t numFrames);
+  // Two-channel output (see ImpulseResponse::ProcessBlock()); mono IRs and
+  // bypass write the same signal to both. `inputs` may alias `left`.
+  void ProcessBlock(const float* inputs, float* left, float* right, size_t numFrames);
+  // Start a block and swap in a committed slot. Returns true if a slot
+  // playing this block needs the output of the folded stages, false if
+  // every live slot has them folded in and they can be skipped.
+  bool BeginBlock(size_t numFrames);
+  // After BeginBlock(): folded slots read `dryInputs` (before the folded
+  // stages), the others `stagedInputs`, which is only read when
+  // BeginBlock() returned true. Either may alias `left`.
+  void ProcessBlock(const float* dryInputs, const float* stagedInputs, float* left, float* right,
+                    size_t numFrames);
+  // Blend position for Dual IRs, applied to both slots from the next block.
+  void SetBlend(float blend) { mBlend = blend; }
+  // After ProcessBlock(): true if the block convolved nothing, the one live
+  // slot being dry or idle (see ImpulseResponse::Idle()).
+  bool Idle() const
+  {
+    const Slot& slot = mSlots[mActive];
+    return !mBlockFading && (slot.bypass || slot.ir.Idle());
+  }
+  // After BeginBlock(): true if the block plays both slots, crossfading or
+  // letting the old one ring out.
+  bool Switching() const { return mBlockFading; }
+  // Fixed-point input samples the playing IR has saturated since it was
+  // loaded (see ImpulseResponse::ClipCount()). A diagnostic that may be
+  // read from the main loop: the count is one aligned word, and a swap in
+  // between at worst reports the other slot's.
+  uint32_t ClipCount() const { return mSlots[mActive].ir.ClipCount(); }
+
+private:
+  enum class State
+  {
+    // Audio owns the active slot, nobody touches the inactive one.
+    Idle,
+    // Control is filling the inactive slot.
+    Loading,
+    // Inactive slot is ready; audio swaps at its next block.
+    Ready,
+    // Audio is processing both slots and crossfading.
+    Fading,
+  };
+
+  struct Slot
+  {
+    ImpulseResponse ir;
+    bool bypass = true;
+    bool folded = false;
+  };
+
+  // `right` may be null for mono.
+  void _ProcessSlot(Slot& slot, const float* inputs, float* left, float* right, size_t numFrames);
+
+  Slot mSlots[2];
+  // Index of the slot the audio side is playing. Written only by the audio
+  // side, and only between observing Ready and publishing Fading.
+  int mActive = 0;
+  std::atomic<State> mState{State::Idle};
+
+  size_t mFadeBlocks = 0;
+  // Crossfade progress in samples, audio side only.
+  size_t mFadePosition = 0;
+  size_t mFadeLength = 0;
+  // Samples the outgoing slot rings on for after the crossfade: its
+  // TailLength(), capped at mFadeLength. Its output fades out over them.
+  size_t mTailLength = 0;
+  // This block is a crossfade, as decided by BeginBlock().
+  bool mBlockFading = false;
+  // Audio side only; handed to each slot just before it processes, so the
+  // control side never races a write into a slot it is initialising.
+  float mBlend = 0.0f;
+  // Input, then output, of the outgoing slot during a crossfade, left and
+  // right.
+  IRMemory::Vector<float, IRMemory::Use::Scratch> mFadeScratch;
+  IRMemory::Vector<float, IRMemory::Use::Scratch> mFadeScratchRight;
+};
@@ -0,0 +1,196 @@
+//
+//  IRMemory.cpp
+//
+//  Memory placement for the convolution engines' buffers.
+//
+
+#include "IRMemory.h"
+
+#include <cstdint>
+
+
+namespace
+{
+// First-fit allocator over one pool. Free blocks form a singly linked list
+// sorted by address, with the node stored in the free block itself, and are
+// merged with their neighbours on release. Sizes are multiples of
+// kAlignment, which is also large enough to hold a node.
+struct FreeBlock
+{
+  size_t size;
+  FreeBlock* next;
+};
+static_assert(sizeof(FreeBlock) <= IRMemory::kAlignment, "kAlignment too small for a free block");
+
+struct Pool
+{
+  uint8_t* base = nullptr;
+  size_t capacity = 0;
+  FreeBlock* freeList = nullptr;
+  IRMemory::Usage usage = {0, 0, 0, 0};
+
+  bool Contains(const void* p) const
+  {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    return base != nullptr && b >= base && b < base + capacity;
+  }
+};
+
+Pool pools[IRMemory::kNumRegions];
+size_t useBytes[IRMemory::kNumUses];
+
+size_t _RoundUp(size_t bytes)
+{
+  return (bytes + IRMemory::kAlignment - 1) & ~(IRMemory::kAlignment - 1);
+}
+
+void* _PoolAllocate(Pool& pool, size_t bytes)
+{
+  FreeBlock** link = &pool.freeList;
+  for (FreeBlock* block = pool.freeList; block != nullptr; link = &block->next, block = block->next)
+  {
+    if (block->size < bytes)
+      continue;
+    if (block->size == bytes)
+    {
+      *link = block->next;
+    }
+    else
+    {
+      // Keep the remainder at the end of the block in the list.
+      FreeBlock* rest = reinterpret_cast<FreeBlock*>(reinterpret_cast<uint8_t*>(block) + bytes);
+      rest->size = block->size - bytes;
+      rest->next = block->next;
+      *link = rest;
+    }
+    pool.usage.used += bytes;
+    if (pool.usage.used > pool.usage.peak)
+      pool.usage.peak = pool.usage.used;
+    return block;
+  }
+  return nullptr;
+}
+
+void _PoolRelease(Pool& pool, void* p, size_t bytes)
+{
+  FreeBlock* block = static_cast<FreeBlock*>(p);
+  block->size = bytes;
+
+  FreeBlock* prev = nullptr;
+  FreeBlock* next = pool.freeList;
+  while (next != nullptr && next < block)
+  {
+    prev = next;
+    next = next->next;
+  }
+
+  // Merge with the following block, then the preceding one.
+  if (next != nullptr && reinterpret_cast<uint8_t*>(block) + block->size == reinterpret_cast<uint8_t*>(next))
+  {
+    block->size += next->size;
+    next = next->next;
+  }
+  block->next = next;
+  if (prev != nullptr && reinterpret_cast<uint8_t*>(prev) + prev->size == reinterpret_cast<uint8_t*>(block))
+  {
+    prev->size += block->size;
+    prev->next = block->next;
+  }
+  else if (prev != nullptr)
+  {
+    prev->next = block;
+  }
+  else
+  {
+    pool.freeList = block;
+  }
+  pool.usage.used -= bytes;
+}
+} // namespace
+
+
+const char* IRMemory::Name(Region region)
+{
+  switch (region)
+  {
+    case Region::Dtcm: return "dtcm";
+    case Region::Axi: return "axi";
+    case Region::Sdram: return "sdram";
+    default: return "heap";
+  }
+}
+
+const char* IRMemory::Name(Use use)
+{
+  switch (use)
+  {
+    case Use::Weights: return "weights";
+    case Use::History: return "history";
+    case Use::Spectra: return "spectra";
+    default: return "scratch";
+  }
+}
+
+void IRMemory::AddRegion(Region region, void* base, size_t size)
+{
+  if (region == Region::Heap)
+    return;
+
+  // Align the pool itself; the allocator relies on it.
+  uint8_t* start = static_cast<uint8_t*>(base);
+  const size_t skip = (kAlignment - (reinterpret_cast<uintptr_t>(start) & (kAlignment - 1))) & (kAlignment - 1);
+  if (size < skip + kAlignment)
+    return;
+
+  Pool& pool = pools[(size_t)region];
+  pool.base = start + skip;
+  pool.capacity = (size - skip) & ~(kAlignment - 1);
+  pool.freeList = reinterpret_cast<FreeBlock*>(pool.base);
+  pool.freeList->size = pool.capacity;
+  pool.freeList->next = nullptr;
+  pool.usage = {pool.capacity, 0, 0, 0};
+}
+
+IRMemory::Usage IRMemory::GetUsage(Region region)
+{
+  return pools[(size_t)region].usage;
+}
+
+size_t IRMemory::GetUsage(Use use)
+{
+  return useBytes[(size_t)use];
+}
+
+void* IRMemory::Allocate(Use use, size_t bytes)
+{
+  const size_t rounded = _RoundUp(bytes == 0 ? 1 : bytes);
+  useBytes[(size_t)use] += rounded;
+
+  Pool& pool = pools[(size_t)Placement(use)];
+  if (void* p = _PoolAllocate(pool, rounded))
+    return p;
+
+  if (Placement(use) != Region::Heap)
+    pool.usage.fallbacks++;
+  return ::operator new(rounded);
+}
+
+void IRMemory::Deallocate(Use use, void* p, size_t bytes)
+{
+  if (p == nullptr)
+    return;
+  const size_t rounded = _RoundUp(bytes == 0 ? 1 : bytes);
+  useBytes[(size_t)use] -= rounded;
+
+  // Containers may be moved around, so find the owner by address rather
+  // than trusting the placement map.
+  for (Pool& pool : pools)
+  {
+    if (pool.Contains(p))
+    {
+      _PoolRelease(pool, p, rounded);
+      return;
+    }
+  }
+  ::operator delete(p);
+}
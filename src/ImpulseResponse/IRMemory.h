@@ -0,0 +1,146 @@
+//
+//  IRMemory.h
+//
+//  Memory placement for the convolution engines' buffers.
+//
+//  The inner loops are memory bound, so where the IR state lives matters as
+//  much as how it is computed. Every engine buffer is tagged with what it is
+//  used for (IRMemory::Use) and allocated through IRMemory::Vector, which
+//  takes it from the memory region the placement map assigns to that use:
+//
+//    Use        Holds                                     Default region
+//    Weights    direct-form taps (float/Q31/Q15)           DTCM
+//    History    direct-form history, FFT input windows     AXI SRAM
+//    Spectra    IR partition spectra                       AXI SRAM
+//    Scratch    FFT tables/work, block staging buffers     DTCM
+//
+//  The map is fixed at build time (make IR_PLACE_WEIGHTS=dtcm|axi|sdram|heap
+//  and likewise IR_PLACE_HISTORY, IR_PLACE_SPECTRA, IR_PLACE_SCRATCH), so the
+//  layout is reproducible across builds. Regions get their backing memory
+//  from the application (AddRegion()), typically static pools declared with
+//  the libDaisy section attributes. A use whose region has no pool, or whose
+//  pool is full, falls back to the heap and is counted in GetUsage().
+//
+//  Not thread safe: allocate only from the main loop (see IRManager), never
+//  from the audio callback.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#define IR_REGION_HEAP 0
+#define IR_REGION_DTCM 1
+#define IR_REGION_AXI 2
+#define IR_REGION_SDRAM 3
+
+#ifndef IR_PLACE_WEIGHTS
+#define IR_PLACE_WEIGHTS IR_REGION_DTCM
+#endif
+#ifndef IR_PLACE_HISTORY
+#define IR_PLACE_HISTORY IR_REGION_AXI
+#endif
+#ifndef IR_PLACE_SPECTRA
+#define IR_PLACE_SPECTRA IR_REGION_AXI
+#endif
+#ifndef IR_PLACE_SCRATCH
+#define IR_PLACE_SCRATCH IR_REGION_DTCM
+#endif
+
+namespace IRMemory
+{
+enum class Region
+{
+  // The default allocator (heap in AXI SRAM on the Daisy).
+  Heap = IR_REGION_HEAP,
+  // 128 KB tightly coupled data RAM: zero wait states, not cached.
+  Dtcm = IR_REGION_DTCM,
+  // 512 KB AXI SRAM behind the D-cache.
+  Axi = IR_REGION_AXI,
+  // 64 MB external SDRAM behind the D-cache: large but slow on a miss.
+  Sdram = IR_REGION_SDRAM,
+};
+constexpr size_t kNumRegions = 4;
+
+enum class Use
+{
+  Weights,
+  History,
+  Spectra,
+  Scratch,
+};
+constexpr size_t kNumUses = 4;
+
+// Pool allocations are rounded up to and aligned on this (one cache line).
+constexpr size_t kAlignment = 32;
+
+// The build-time placement map.
+constexpr Region Placement(Use use)
+{
+  return use == Use::Weights   ? (Region)IR_PLACE_WEIGHTS
+         : use == Use::History ? (Region)IR_PLACE_HISTORY
+         : use == Use::Spectra ? (Region)IR_PLACE_SPECTRA
+                               : (Region)IR_PLACE_SCRATCH;
+}
+
+const char* Name(Region region);
+const char* Name(Use use);
+
+// Hand `size` bytes at `base` to `region`. Call once per region, before the
+// first engine Init(). Heap can't be given a pool.
+void AddRegion(Region region, void* base, size_t size);
+
+struct Usage
+{
+  // Pool bytes given to the region (0 if it has none).
+  size_t capacity;
+  size_t used;
+  // High-water mark of `used`.
+  size_t peak;
+  // Allocations meant for this region that went to the heap instead.
+  size_t fallbacks;
+};
+Usage GetUsage(Region region);
+// Bytes currently allocated for one use, wherever they ended up.
+size_t GetUsage(Use use);
+
+void* Allocate(Use use, size_t bytes);
+void Deallocate(Use use, void* p, size_t bytes);
+
+// Stateless allocator placing a container's storage according to its Use.
+template <typename T, Use U>
+struct Allocator
+{
+  using value_type = T;
+  template <typename Other>
+  struct rebind
+  {
+    using other = Allocator<Other, U>;
+  };
+
+  Allocator() = default;
+  template <typename Other>
+  Allocator(const Allocator<Other, U>&)
+  {
+  }
+
+  T* allocate(size_t n) { return static_cast<T*>(IRMemory::Allocate(U, n * sizeof(T))); }
+  void deallocate(T* p, size_t n) { IRMemory::Deallocate(U, p, n * sizeof(T)); }
+
+  template <typename Other>
+  bool operator==(const Allocator<Other, U>&) const
+  {
+    return true;
+  }
+  template <typename Other>
+  bool operator!=(const Allocator<Other, U>&) const
+  {
+    return false;
+  }
+};
+
+template <typename T, Use U>
+using Vector = std::vector<T, Allocator<T, U>>;
+} // namespace IRMemory
@@ -10,6 +10,23 @@
 
 #include "ImpulseResponse.h"
 
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+// Length without trailing zero taps, so IRs padded to a fixed length (older
+// headers, --no-trim) only cost what they actually contain.
+template <typename T>
+size_t _TrimmedLength(const T* irData, size_t irLength)
+{
+  while (irLength > 1 && irData[irLength - 1] == T(0))
+    irLength--;
+  return irLength;
+}
+} // namespace
+
 
 ImpulseResponse::ImpulseResponse()
 {
@@ -22,31 +39,417 @@ ImpulseResponse::~ImpulseResponse()
 }
 
 
-void ImpulseResponse::Init(const float* irData, size_t irLength)
+void ImpulseResponse::Init(const float* irData, size_t irLength, Engine engine, size_t partitionSize)
 {
   mRawAudio = irData;
   mRawAudioLength = irLength;
-  _SetWeights();
+  // Without the offline split there's no tail to run at a reduced rate.
+  mEngine = engine == Engine::MultiRate ? Engine::Direct : engine;
+  const size_t length = _TrimmedLength(mRawAudio, std::min(mRawAudioLength, mMaxLength));
+  const size_t latency = mEngine == Engine::Partitioned ? partitionSize : 0;
+  _ResetIdle(length + latency, latency);
+  _AddResidual(mRawAudio, length);
+
+  if (mEngine == Engine::Partitioned)
+  {
+    mConvolver.Init(mRawAudio, length, partitionSize);
+    mBlockInput.assign(partitionSize, 0.0f);
+    mBlockOutput.assign(partitionSize, 0.0f);
+    mBlockPosition = 0;
+    mStaged = false;
+    // The direct-form weights and history aren't used by this engine.
+    _ReleaseFloatState();
+    return;
+  }
+
+  if (mEngine == Engine::Hybrid)
+  {
+    const size_t head = NonUniformConvolver::HeadLength(kHybridFirstPartition);
+    _SetWeights(std::min(length, head));
+    mTail.Init(mRawAudio, length, kHybridFirstPartition, kHybridMaxPartition);
+    return;
+  }
+
+  if (mPrecision == Precision::Q31)
+  {
+    mFixedQ31.Init(mRawAudio, length, mHeadroomBits, mHistoryMode, kMaxBlockSize);
+    _ReleaseFloatState();
+    return;
+  }
+  if (mPrecision == Precision::Q15)
+  {
+    mFixedQ15.Init(mRawAudio, length, mHeadroomBits, mHistoryMode, kMaxBlockSize);
+    _ReleaseFloatState();
+    return;
+  }
+
+  _SetWeights(length);
+}
+
+void ImpulseResponse::Init(const int16_t* irData, size_t irLength, int weightShift)
+{
+  mEngine = Engine::Direct;
+  mPrecision = Precision::Q15;
+  const size_t length = _TrimmedLength(irData, std::min(irLength, mMaxLength));
+  _ResetIdle(length);
+  _AddResidual(irData, length, std::ldexp(1.0f, -(15 + weightShift)));
+  mFixedQ15.Init(irData, length, weightShift, mHeadroomBits, mHistoryMode, kMaxBlockSize);
+  _ReleaseFloatState();
+}
+
+void ImpulseResponse::Init(const int32_t* irData, size_t irLength, int weightShift)
+{
+  mEngine = Engine::Direct;
+  mPrecision = Precision::Q31;
+  const size_t length = _TrimmedLength(irData, std::min(irLength, mMaxLength));
+  _ResetIdle(length);
+  _AddResidual(irData, length, std::ldexp(1.0f, -(31 + weightShift)));
+  mFixedQ31.Init(irData, length, weightShift, mHeadroomBits, mHistoryMode, kMaxBlockSize);
+  _ReleaseFloatState();
+}
+
+void ImpulseResponse::Init(const std::complex<float>* irSpectra, size_t irLength, size_t partitionSize)
+{
+  mRawAudio = nullptr;
+  mRawAudioLength = irLength;
+  mEngine = Engine::Partitioned;
+  const size_t length = std::min(irLength, mMaxLength);
+  _ResetIdle(length + partitionSize, partitionSize);
+  mConvolver.Init(irSpectra, (length + partitionSize - 1) / partitionSize, partitionSize);
+  mBlockInput.assign(partitionSize, 0.0f);
+  mBlockOutput.assign(partitionSize, 0.0f);
+  mBlockPosition = 0;
+  mStaged = false;
+  _ReleaseFloatState();
+}
+
+void ImpulseResponse::Init(const float* headData, size_t headLength, const float* tailData, size_t tailLength,
+                           size_t tailRate, size_t tailSplit)
+{
+  mRawAudio = headData;
+  mRawAudioLength = headLength;
+  mEngine = Engine::MultiRate;
+  _SetWeights(_TrimmedLength(mRawAudio, std::min(mRawAudioLength, mMaxLength)));
+  mMultiRate.Init(tailData, std::min(tailLength, mMaxLength), tailRate, tailSplit);
+  // The tail runs out tailRate * tailLength samples past the split, plus
+  // the decimation and interpolation filters.
+  _ResetIdle(std::max(headLength, tailSplit + tailRate * std::min(tailLength, mMaxLength)
+                                       + 2 * MultiRateConvolver::Latency(tailRate)));
+}
+
+void ImpulseResponse::Init(const float* irDataA, size_t irLengthA, const float* irDataB, size_t irLengthB,
+                           DualMode mode, size_t partitionSize)
+{
+  mRawAudio = irDataA;
+  mRawAudioLength = irLengthA;
+  mEngine = Engine::Dual;
+  mDualMode = mode;
+  const float* irData[] = {irDataA, irDataB};
+  const size_t irLengths[] = {_TrimmedLength(irDataA, std::min(irLengthA, mMaxLength)),
+                              _TrimmedLength(irDataB, std::min(irLengthB, mMaxLength))};
+  mDual.Init(irData, irLengths, 2, partitionSize);
+  _ResetIdle(std::max(irLengths[0], irLengths[1]) + partitionSize, partitionSize);
+  // Either output is at most the larger of the two IRs' remaining sums.
+  _AddResidual(irDataA, irLengths[0]);
+  _AddResidual(irDataB, irLengths[1]);
+  mBlockInput.assign(partitionSize, 0.0f);
+  mBlockOutput.assign(2 * partitionSize, 0.0f);
+  mBlockPosition = 0;
+  mStaged = false;
+  _ReleaseFloatState();
+}
+
+uint32_t ImpulseResponse::ClipCount() const
+{
+  if (!_IsFixedPoint())
+    return 0;
+  return mPrecision == Precision::Q15 ? mFixedQ15.ClipCount() : mFixedQ31.ClipCount();
+}
+
+void ImpulseResponse::_ResetIdle(size_t span, size_t latency)
+{
+  mIdleFrames = std::max<size_t>(span, 1);
+  mIdleLatency = latency;
+  mQuietFrames = 0;
+  mLoudPeak = 0.0f;
+  mIdle = false;
+  mHasResidual = false;
+}
+
+template <typename T>
+void ImpulseResponse::_AddResidual(const T* irData, size_t irLength, float scale)
+{
+  if (!mHasResidual)
+    std::fill(mResidual, mResidual + kResidualPoints, 0.0f);
+  mHasResidual = true;
+  // Suffix sums, a step at a time from the end.
+  float sum = 0.0f;
+  for (size_t j = kResidualPoints; j-- > 0;)
+  {
+    const size_t start = j * kResidualStep;
+    for (size_t k = std::min(irLength, start + kResidualStep); k > start; k--)
+      sum += std::fabs((float)irData[k - 1]) * scale;
+    mResidual[j] = std::max(mResidual[j], sum);
+  }
+}
+
+bool ImpulseResponse::_SkipBlock(const float* inputs, size_t numFrames)
+{
+  if (mSilenceThreshold <= 0.0f)
+    return false;
+
+  float peak = 0.0f;
+  for (size_t i = 0; i < numFrames; i++)
+    peak = std::max(peak, std::fabs(inputs[i]));
+  if (peak >= mSilenceThreshold)
+  {
+    mQuietFrames = 0;
+    mLoudPeak = std::max(mLoudPeak, peak);
+    mIdle = false;
+    return false;
+  }
+  if (mIdle)
+    return true;
+
+  // Every loud input in the history is at least mQuietFrames old, so
+  // together they can add at most mLoudPeak times the IR's sum |h| from
+  // that age on. Judged before this block's input goes in, so the block
+  // that gets the bound under the threshold still runs.
+  float remaining = mQuietFrames >= mIdleFrames ? 0.0f : INFINITY;
+  if (mHasResidual && mQuietFrames < mIdleFrames)
+  {
+    const size_t age = mQuietFrames > mIdleLatency ? mQuietFrames - mIdleLatency : 0;
+    remaining = mLoudPeak * mResidual[std::min(age / kResidualStep, kResidualPoints - 1)];
+  }
+  if (remaining < mSilenceThreshold)
+  {
+    // Resume from silence rather than from state a whole silence old.
+    _ClearState();
+    mLoudPeak = 0.0f;
+    mIdle = true;
+    return true;
+  }
+  mQuietFrames = std::min(mQuietFrames + numFrames, mIdleFrames);
+  return false;
+}
+
+void ImpulseResponse::_ClearState()
+{
+  switch (mEngine)
+  {
+    case Engine::Partitioned:
+      mConvolver.Reset();
+      break;
+    case Engine::Dual:
+      mDual.Reset();
+      break;
+    case Engine::Hybrid:
+      _ClearHistory();
+      mTail.Reset();
+      break;
+    case Engine::MultiRate:
+      _ClearHistory();
+      mMultiRate.Reset();
+      break;
+    case Engine::Direct:
+      if (!_IsFixedPoint())
+        _ClearHistory();
+      else if (mPrecision == Precision::Q15)
+        mFixedQ15.Reset();
+      else
+        mFixedQ31.Reset();
+      break;
+  }
+  std::fill(mBlockInput.begin(), mBlockInput.end(), 0.0f);
+  std::fill(mBlockOutput.begin(), mBlockOutput.end(), 0.0f);
+  mBlockPosition = 0;
+}
+
+void ImpulseResponse::_ReleaseFloatState()
+{
+  mWeight.clear();
+  mWeight.shrink_to_fit();
+  mHistory.clear();
+  mHistory.shrink_to_fit();
+}
+
+void ImpulseResponse::_ProcessDual(const float* inputs, float* left, float* right)
+{
+  if (mDualMode == DualMode::Stereo)
+  {
+    const float gains[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    float* outputs[] = {left, right};
+    mDual.Process(inputs, gains, right ? 2 : 1, outputs);
+    return;
+  }
+
+  // The blend is mixed in the frequency domain: one inverse FFT for both IRs.
+  const float blend = std::min(std::max(mBlend, 0.0f), 1.0f);
+  const float gains[] = {1.0f - blend, blend};
+  float* outputs[] = {left};
+  mDual.Process(inputs, gains, 1, outputs);
+  if (right)
+    std::copy(left, left + mDual.PartitionSize(), right);
+}
+
+void ImpulseResponse::_ProcessPartition(const float* inputs, float* left, float* right)
+{
+  if (mEngine == Engine::Dual)
+    _ProcessDual(inputs, left, right);
+  else
+    mConvolver.Process(inputs, left);
+}
+
+void ImpulseResponse::_ProcessPartitions(const float* inputs, float* left, float* right, size_t numFrames)
+{
+  // Running whole partitions straight through and staging the rest would
+  // put the output on two timelines a partition apart, so once staging is
+  // needed everything goes through it.
+  const size_t partitionSize = mBlockInput.size();
+  float* stagedRight = mEngine == Engine::Dual ? mBlockOutput.data() + partitionSize : nullptr;
+  if (!mStaged && numFrames % partitionSize != 0)
+  {
+    // Unstaged blocks always end on a partition boundary. Running one
+    // partition of silence there yields exactly the ring-out of the input so
+    // far, which plays while the first staged partition fills: no gap, and
+    // only the input from here on comes out a partition later.
+    std::fill(mBlockInput.begin(), mBlockInput.end(), 0.0f);
+    _ProcessPartition(mBlockInput.data(), mBlockOutput.data(), stagedRight);
+    mBlockPosition = 0;
+    mStaged = true;
+  }
+
+  if (!mStaged)
+  {
+    for (size_t i = 0; i < numFrames; i += partitionSize)
+      _ProcessPartition(inputs + i, left + i, right ? right + i : nullptr);
+    return;
+  }
+
+  for (size_t i = 0; i < numFrames; i++)
+  {
+    mBlockInput[mBlockPosition] = inputs[i];
+    left[i] = mBlockOutput[mBlockPosition];
+    if (right && stagedRight)
+      right[i] = stagedRight[mBlockPosition];
+    if (++mBlockPosition == partitionSize)
+    {
+      _ProcessPartition(mBlockInput.data(), mBlockOutput.data(), stagedRight);
+      mBlockPosition = 0;
+    }
+  }
 }
 
 float ImpulseResponse::Process(float inputs)
 {
+  if (mEngine == Engine::Dual)
+  {
+    float output;
+    ProcessBlock(&inputs, &output, nullptr, 1);
+    return output;
+  }
+
+  if (mEngine == Engine::Partitioned)
+  {
+    float output;
+    _ProcessPartitions(&inputs, &output, nullptr, 1);
+    return output;
+  }
+
+  if (_IsFixedPoint())
+    return mPrecision == Precision::Q15 ? mFixedQ15.Process(inputs) : mFixedQ31.Process(inputs);
 
   _UpdateHistory(inputs);
 
-  int j = mHistoryIndex - mHistoryRequired;
-  auto input = Eigen::Map<const Eigen::VectorXf>(&mHistory[j], mHistoryRequired + 1);
+  const float output = FirKernel::Dot(mWeight.data(), _HistoryWindow(), mWeight.size());
 
   _AdvanceHistoryIndex(1); // KAB MOD - for Daisy implementation numFrames is always 1
 
-  return (float)mWeight.dot(input);
+  if (mEngine == Engine::Hybrid)
+    return output + mTail.Process(inputs);
+  if (mEngine == Engine::MultiRate)
+    return output + mMultiRate.Process(inputs);
+
+  return output;
+
+}
+
+void ImpulseResponse::ProcessBlock(const float* inputs, float* left, float* right, size_t numFrames)
+{
+  if (mEngine != Engine::Dual)
+  {
+    ProcessBlock(inputs, left, numFrames);
+    if (right)
+      std::copy(left, left + numFrames, right);
+    return;
+  }
 
+  if (_SkipBlock(inputs, numFrames))
+  {
+    std::fill(left, left + numFrames, 0.0f);
+    if (right)
+      std::fill(right, right + numFrames, 0.0f);
+    return;
+  }
+
+  _ProcessPartitions(inputs, left, right, numFrames);
 }
 
-void ImpulseResponse::_SetWeights()
+void ImpulseResponse::ProcessBlock(const float* inputs, float* outputs, size_t numFrames)
+{
+  if (mEngine == Engine::Dual)
+  {
+    ProcessBlock(inputs, outputs, nullptr, numFrames);
+    return;
+  }
+
+  if (_SkipBlock(inputs, numFrames))
+  {
+    std::fill(outputs, outputs + numFrames, 0.0f);
+    return;
+  }
+
+  if (mEngine == Engine::Partitioned)
+  {
+    _ProcessPartitions(inputs, outputs, nullptr, numFrames);
+    return;
+  }
+
+  if (_IsFixedPoint())
+  {
+    if (mPrecision == Precision::Q15)
+      mFixedQ15.ProcessBlock(inputs, outputs, numFrames);
+    else
+      mFixedQ31.ProcessBlock(inputs, outputs, numFrames);
+    return;
+  }
+
+  const size_t maxBlock = _MaxHistoryBlock();
+  for (size_t done = 0; done < numFrames;)
+  {
+    const size_t n = std::min(numFrames - done, maxBlock);
+    _UpdateHistory(inputs + done, n);
+
+    // The block's own inputs now live at mHistoryIndex, so the tail below
+    // reads them from there in case `outputs` aliases `inputs`.
+    const float* window = _HistoryWindow();
+    const float* block = window + mHistoryRequired;
+    FirKernel::Convolve(mWeight.data(), mWeight.size(), window, outputs + done, n);
+    if (mEngine == Engine::Hybrid)
+      for (size_t i = 0; i < n; i++)
+        outputs[done + i] += mTail.Process(block[i]);
+    else if (mEngine == Engine::MultiRate)
+      for (size_t i = 0; i < n; i++)
+        outputs[done + i] += mMultiRate.Process(block[i]);
+
+    _AdvanceHistoryIndex(n);
+    done += n;
+  }
+}
+
+void ImpulseResponse::_SetWeights(size_t irLength)
 {
 
-  const size_t irLength = std::min(mRawAudioLength, mMaxLength);
   mWeight.resize(irLength);
   // Gain reduction.
   // https://github.com/sdatkinson/NeuralAmpModelerPlugin/issues/100#issuecomment-1455273839
@@ -55,14 +458,7 @@ void ImpulseResponse::_SetWeights()
   for (size_t i = 0, j = irLength - 1; i < irLength; i++, j--)
     //mWeight[j] = gain * mRawAudio[i];
     mWeight[j] = mRawAudio[i];
-  mHistoryRequired = irLength - 1;
-
-  // Moved from HISTORY::EnsureHistorySize since only doing once for this module (assuming same size IR's)
-  //   TODO: Maybe find a more efficient method of indexing mHistory,
-  //         rather than copying the end of the vector (length of IR) back to the beginning all at once.
-  const size_t requiredHistoryArraySize = 5 * mHistoryRequired; // Just so we don't spend too much time copying back. // KAB NOTE: was 10 *
-  mHistory.resize(requiredHistoryArraySize);
-  std::fill(mHistory.begin(), mHistory.end(), 0.0f);
-  mHistoryIndex = mHistoryRequired;
+
+  _ResetHistory(irLength - 1, mHistoryMode, kMaxBlockSize);
 
 }
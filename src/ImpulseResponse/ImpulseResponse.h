@@ -12,24 +12,213 @@
 
 #pragma once
 
-#include <Eigen/Dense>
+#include <complex>
+
 #include "dsp.h"
+#include "FirKernel.h"
+#include "FixedPointFir.h"
+#include "IRMemory.h"
+#include "MultiIRConvolver.h"
+#include "MultiRateConvolver.h"
+#include "NonUniformConvolver.h"
+#include "PartitionedConvolver.h"
+
+// Set one of these to 1 at build time (make IR_ENGINE=partitioned or
+// IR_ENGINE=hybrid) to change the default engine for Init().
+#ifndef IR_ENGINE_PARTITIONED
+#define IR_ENGINE_PARTITIONED 0
+#endif
+#ifndef IR_ENGINE_HYBRID
+#define IR_ENGINE_HYBRID 0
+#endif
+// Likewise for the sample format of the direct engine
+// (make IR_PRECISION=q31 or IR_PRECISION=q15).
+#ifndef IR_PRECISION_Q31
+#define IR_PRECISION_Q31 0
+#endif
+#ifndef IR_PRECISION_Q15
+#define IR_PRECISION_Q15 0
+#endif
 
 
 class ImpulseResponse : public History
 {
 public:
+  // Convolution engine used for Process().
+  enum class Engine
+  {
+    // Time-domain dot product over the whole IR for every sample.
+    Direct,
+    // Uniformly partitioned overlap-save FFT convolution. Adds one partition
+    // of latency when driven one sample at a time.
+    Partitioned,
+    // Direct-form head for the first few dozen taps plus a non-uniformly
+    // partitioned FFT tail. No added latency.
+    Hybrid,
+    // Direct-form head plus a tail convolved at 1/2 or 1/4 rate
+    // (MultiRateConvolver). Needs the split IR from wav_to_ir_header.py
+    // --multirate; a plain float IR given this engine runs Direct.
+    MultiRate,
+    // Two IRs on one partitioned engine sharing the input FFT
+    // (MultiIRConvolver), blended to one output or one per channel.
+    Dual,
+  };
+
+  // How a Dual engine maps its two IRs onto the outputs.
+  enum class DualMode
+  {
+    // One output: (1 - blend) * A + blend * B.
+    Blend,
+    // A on the left output, B on the right.
+    Stereo,
+  };
+
+  static constexpr Engine kDefaultEngine = IR_ENGINE_HYBRID ? Engine::Hybrid
+                                           : IR_ENGINE_PARTITIONED ? Engine::Partitioned
+                                                                   : Engine::Direct;
+
+  // Hybrid engine layout: the direct head is 2 * kHybridFirstPartition taps,
+  // tail partitions double from there up to kHybridMaxPartition.
+  static constexpr size_t kHybridFirstPartition = 16;
+  static constexpr size_t kHybridMaxPartition = 256;
+
+  // Sample format of the direct engine's weights and history. The FFT
+  // engines always run in float.
+  enum class Precision
+  {
+    Float,
+    // 32-bit fixed point, 64-bit accumulation.
+    Q31,
+    // 16-bit fixed point: half the memory traffic, dual MACs on the M7.
+    Q15,
+  };
+
+  static constexpr Precision kDefaultPrecision = IR_PRECISION_Q15 ? Precision::Q15
+                                                 : IR_PRECISION_Q31 ? Precision::Q31
+                                                                    : Precision::Float;
+
+  // Fixed-point input headroom: inputs up to 2^kDefaultHeadroomBits full
+  // scale (e.g. the bass boost's +12 dB) convolve without saturating.
+  static constexpr int kDefaultHeadroomBits = 2;
+
+  // Largest block the mirrored history is sized for without splitting.
+  // Keeps the ring at 8192 samples for a full-length 8160-tap IR.
+  static constexpr size_t kMaxBlockSize = 32;
+
+  // Suggested idle gate level for SetSilenceThreshold(): -80 dBFS.
+  static constexpr float kDefaultSilenceThreshold = 0.0001f;
+  // Resolution, in taps, of the IR envelope the idle gate bounds the
+  // history's remaining output with.
+  static constexpr size_t kResidualStep = 64;
+  static constexpr size_t kResidualPoints = 8192 / kResidualStep + 1;
+
   ImpulseResponse();
   ~ImpulseResponse();
 
-  void Init(const float* irData, size_t irLength);
+  // `partitionSize` is only used by the partitioned engine and should match
+  // the audio block size. It must be a power of two.
+  // Every engine's cost scales with the IR length, so pass the trimmed
+  // length (IRInfo.length); trailing zero taps are dropped regardless.
+  void Init(const float* irData, size_t irLength, Engine engine = kDefaultEngine,
+            size_t partitionSize = 8);
+  // Direct engine on an IR quantised offline (natural order), where
+  // weight = irData[i] * 2^-(15|31 + weightShift). Selects Q15/Q31.
+  void Init(const int16_t* irData, size_t irLength, int weightShift);
+  void Init(const int32_t* irData, size_t irLength, int weightShift);
+  // Partitioned engine on IR spectra computed offline (wav_to_ir_header.py
+  // --spectra), covering the first `irLength` taps. `partitionSize` must
+  // match the one the spectra were generated for.
+  void Init(const std::complex<float>* irSpectra, size_t irLength, size_t partitionSize);
+  // Multi-rate engine on an IR split offline (wav_to_ir_header.py
+  // --multirate): a full-rate head, and a tail of `tailLength` taps at
+  // 1/`tailRate` rate starting `tailSplit` samples in (see
+  // MultiRateConvolver::Init()).
+  void Init(const float* headData, size_t headLength, const float* tailData, size_t tailLength, size_t tailRate,
+            size_t tailSplit);
+  // Dual engine on two IRs convolved with the same input. Like the
+  // partitioned engine, `partitionSize` should match the audio block size.
+  void Init(const float* irDataA, size_t irLengthA, const float* irDataB, size_t irLengthB, DualMode mode,
+            size_t partitionSize);
+  // Mono output; a Dual engine gives its blend (or IR A in stereo mode).
   float Process(float inputs);
+  // Process a whole audio block. `inputs` and `outputs` may alias.
+  // The partitioned and Dual engines add no latency while every block is a
+  // multiple of the partition size. The first block that isn't, or a call
+  // to Process(), moves them to one partition of latency until the next
+  // Init(). Output already under way plays on across that switch; only
+  // input from then on is delayed.
+  void ProcessBlock(const float* inputs, float* outputs, size_t numFrames);
+  // Two-channel block: a stereo Dual engine writes IR A left and IR B
+  // right, every other engine writes its mono output to both. `right` may
+  // be null for just the left. `inputs` may alias `left`.
+  void ProcessBlock(const float* inputs, float* left, float* right, size_t numFrames);
+
+  // Dual blend position in [0, 1]: 0 is all IR A, 1 all IR B. Applied per
+  // block; ignored by the other engines and by stereo mode.
+  void SetBlend(float blend) { mBlend = blend; }
+
+  Engine GetEngine() const { return mEngine; }
+
+  // History layout for the direct-form paths; takes effect on the next Init().
+  // Mirrored (the default) never pays for a rewind copy and needs 2x the
+  // IR length instead of 5x.
+  void SetHistoryMode(HistoryMode mode) { mHistoryMode = mode; }
+
+  // Sample format for the direct engine; takes effect on the next float Init().
+  void SetPrecision(Precision precision, int headroomBits = kDefaultHeadroomBits)
+  {
+    mPrecision = precision;
+    mHeadroomBits = headroomBits;
+  }
+  Precision GetPrecision() const { return mPrecision; }
+
+  // Fixed-point input samples that saturated since Init().
+  uint32_t ClipCount() const;
+
+  // Idle gate level (peak, linear); 0, the default, disables it. While
+  // the input stays below it, the gate bounds what the history can still
+  // add to the output: the loudest input since the gate last went idle
+  // times the IR's remaining sum |h| past the newest loud input. Once that
+  // is below the threshold too (or the whole IR span has passed, for IRs
+  // given as spectra or split for MultiRate), the engine state is cleared
+  // and ProcessBlock() outputs zeros instead of convolving. Convolution
+  // resumes from silence when the input returns, exactly as after Init(),
+  // so it differs from an ungated run by no more than what was skipped.
+  void SetSilenceThreshold(float threshold) { mSilenceThreshold = threshold; }
+  // True while ProcessBlock() is skipping convolution.
+  bool Idle() const { return mIdle; }
+  // Samples for which an input still affects the output: the IR length
+  // plus the engine's latency.
+  size_t TailLength() const { return mIdleFrames; }
 
 
 private:
-  // Set the weights, given that the plugin is running at the provided sample
-  // rate.
-  void _SetWeights();
+  // True when Process() runs through one of the fixed-point convolvers.
+  bool _IsFixedPoint() const { return mEngine == Engine::Direct && mPrecision != Precision::Float; }
+  // Drop the float direct-form state when another engine/precision owns the IR.
+  void _ReleaseFloatState();
+  // Reset the idle gate for an IR whose output depends on the last `span`
+  // input samples, `latency` of them the engine's own delay. The IR
+  // envelope starts out unknown; _AddResidual() fills it in.
+  void _ResetIdle(size_t span, size_t latency = 0);
+  // Widen the idle gate's envelope to cover an IR with `scale` per unit tap.
+  template <typename T>
+  void _AddResidual(const T* irData, size_t irLength, float scale = 1.0f);
+  // Feed a block's input level to the idle gate; true if it can be skipped.
+  bool _SkipBlock(const float* inputs, size_t numFrames);
+  // Zero every engine's input state, keeping the IR.
+  void _ClearState();
+  // One partition of the Dual engine. `right` may be null.
+  void _ProcessDual(const float* inputs, float* left, float* right);
+  // One partition of the partitioned or Dual engine. `right` may be null.
+  void _ProcessPartition(const float* inputs, float* left, float* right);
+  // Any number of frames through the partitioned or Dual engine, at the
+  // latency described for ProcessBlock(). `right` may be null.
+  void _ProcessPartitions(const float* inputs, float* left, float* right, size_t numFrames);
+
+  // Set the weights for direct convolution of the first `irLength` taps,
+  // given that the plugin is running at the provided sample rate.
+  void _SetWeights(size_t irLength);
 
   // State of audio
   // Raw pointer to IR data (owned externally, e.g., RAM buffer)
@@ -39,6 +228,40 @@ private:
   float mSampleRate;
 
   const size_t mMaxLength = 8192;
-  // The weights
-  Eigen::VectorXf mWeight;
+  // The weights, time-reversed for FirKernel
+  IRMemory::Vector<float, IRMemory::Use::Weights> mWeight;
+
+  Engine mEngine = Engine::Direct;
+  Precision mPrecision = kDefaultPrecision;
+  int mHeadroomBits = kDefaultHeadroomBits;
+  FixedPointFir<int32_t> mFixedQ31;
+  FixedPointFir<int16_t> mFixedQ15;
+  PartitionedConvolver mConvolver;
+  NonUniformConvolver mTail;
+  MultiRateConvolver mMultiRate;
+  MultiIRConvolver mDual;
+  DualMode mDualMode = DualMode::Blend;
+  float mBlend = 0.0f;
+  // Per-sample staging for the partitioned and Dual engines: inputs are
+  // collected into mBlockInput while the previous block's results drain
+  // from mBlockOutput (left then right for Dual).
+  IRMemory::Vector<float, IRMemory::Use::Scratch> mBlockInput;
+  IRMemory::Vector<float, IRMemory::Use::Scratch> mBlockOutput;
+  size_t mBlockPosition = 0;
+  // Set once a block that isn't a whole number of partitions has gone
+  // through the staging above; until then partitions run straight through.
+  bool mStaged = false;
+
+  float mSilenceThreshold = 0.0f;
+  bool mIdle = false;
+  // Consecutive input samples below the threshold, saturating at mIdleFrames.
+  size_t mQuietFrames = 0;
+  size_t mIdleFrames = 1;
+  size_t mIdleLatency = 0;
+  // Loudest input since the gate was last idle.
+  float mLoudPeak = 0.0f;
+  // mResidual[j] is the sum of |h| from tap j * kResidualStep on, if
+  // mHasResidual; zero past the IR.
+  float mResidual[kResidualPoints];
+  bool mHasResidual = false;
 };
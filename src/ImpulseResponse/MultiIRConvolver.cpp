@@ -0,0 +1,90 @@
+//
+//  MultiIRConvolver.cpp
+//
+//  Partitioned convolution of one input with several IRs, sharing the
+//  input transform.
+//
+
+#include "MultiIRConvolver.h"
+
+#include <algorithm>
+
+
+MultiIRConvolver::MultiIRConvolver()
+{
+}
+
+// Destructor
+MultiIRConvolver::~MultiIRConvolver()
+{
+    // No Code Needed
+}
+
+
+void MultiIRConvolver::Init(const float* const* irData, const size_t* irLengths, size_t numIRs, size_t partitionSize)
+{
+  mPartitionSize = partitionSize;
+  mNumIRs = std::min(numIRs, kMaxIRs);
+
+  size_t numPartitions = 1;
+  for (size_t i = 0; i < mNumIRs; i++)
+  {
+    mIRPartitions[i] = FrequencyDelayLine::NumPartitions(irLengths[i], partitionSize);
+    numPartitions = std::max(numPartitions, mIRPartitions[i]);
+  }
+  mInput.Init(partitionSize, numPartitions);
+  mNumBins = mInput.NumBins();
+
+  for (size_t i = 0; i < mNumIRs; i++)
+  {
+    mIRSpectra[i].assign(mIRPartitions[i] * mNumBins, std::complex<float>(0.0f, 0.0f));
+    mInput.TransformIR(irData[i], irLengths[i], mIRSpectra[i].data());
+    mAccumulator[i].assign(mNumBins, std::complex<float>(0.0f, 0.0f));
+  }
+  for (size_t i = mNumIRs; i < kMaxIRs; i++)
+  {
+    mIRSpectra[i].clear();
+    mAccumulator[i].clear();
+    mIRPartitions[i] = 0;
+  }
+  mMix.assign(mNumBins, std::complex<float>(0.0f, 0.0f));
+}
+
+void MultiIRConvolver::Reset()
+{
+  mInput.Reset();
+}
+
+void MultiIRConvolver::Process(const float* input, const float* gains, size_t numOutputs, float* const* outputs)
+{
+  // Transform the input once for every IR.
+  mInput.Push(input);
+  mInput.Forward();
+
+  // Complex multiply-accumulate of every IR against the shared delay line.
+  for (size_t i = 0; i < mNumIRs; i++)
+  {
+    std::fill(mAccumulator[i].begin(), mAccumulator[i].end(), std::complex<float>(0.0f, 0.0f));
+    mInput.Accumulate(mAccumulator[i].data(), mIRSpectra[i].data(), 0, mIRPartitions[i]);
+  }
+  mInput.Advance();
+
+  // Mix in the frequency domain, then one inverse transform per output.
+  for (size_t o = 0; o < std::min(numOutputs, kMaxOutputs); o++)
+  {
+    float* mix = reinterpret_cast<float*>(mMix.data());
+    std::fill(mix, mix + 2 * mNumBins, 0.0f);
+    for (size_t i = 0; i < mNumIRs; i++)
+    {
+      const float gain = gains[o * mNumIRs + i];
+      if (gain == 0.0f)
+        continue;
+      const float* acc = reinterpret_cast<const float*>(mAccumulator[i].data());
+      for (size_t b = 0; b < 2 * mNumBins; b++)
+        mix[b] += gain * acc[b];
+    }
+    mInput.Inverse(mMix.data());
+    const float* result = mInput.Output();
+    std::copy(result, result + mPartitionSize, outputs[o]);
+  }
+}
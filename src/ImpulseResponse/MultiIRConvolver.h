@@ -0,0 +1,62 @@
+//
+//  MultiIRConvolver.h
+//
+//  Uniformly partitioned overlap-save convolution of one input with several
+//  IRs at once, e.g. two mics on the same cab to blend, or a different IR
+//  per output channel.
+//
+//  Everything that depends only on the input is shared: one
+//  FrequencyDelayLine, so one overlap-save window, one forward FFT per
+//  block and one ring of input spectra. Each IR adds its own complex
+//  multiply-accumulate pass. The outputs are
+//  mixed from the IRs' accumulators in the frequency domain, so a blend of
+//  any number of IRs costs a single inverse FFT; only separate output
+//  channels pay for one each.
+//
+
+#pragma once
+
+#include <complex>
+
+#include "FrequencyDelayLine.h"
+#include "IRMemory.h"
+
+
+class MultiIRConvolver
+{
+public:
+  static constexpr size_t kMaxIRs = 2;
+  static constexpr size_t kMaxOutputs = 2;
+
+  MultiIRConvolver();
+  ~MultiIRConvolver();
+
+  // Transform `numIRs` IRs (up to kMaxIRs) into partition spectra and clear
+  // all state. `partitionSize` must be a power of two.
+  void Init(const float* const* irData, const size_t* irLengths, size_t numIRs, size_t partitionSize);
+
+  // Clear the input and delay line, keeping the IR spectra.
+  void Reset();
+
+  // Process exactly PartitionSize() samples. Output o is the sum over IRs i
+  // of gains[o * NumIRs() + i] times IR i's convolution, for `numOutputs`
+  // outputs (up to kMaxOutputs). `input` may alias an output.
+  void Process(const float* input, const float* gains, size_t numOutputs, float* const* outputs);
+
+  size_t PartitionSize() const { return mPartitionSize; }
+  size_t NumIRs() const { return mNumIRs; }
+
+private:
+  size_t mPartitionSize = 0;
+  size_t mNumBins = 0;
+  size_t mNumIRs = 0;
+
+  // Sized for the most partitions of any IR.
+  FrequencyDelayLine mInput;
+  // Per IR: partition spectra, pre-scaled by 1/FFT size, and how many.
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Spectra> mIRSpectra[kMaxIRs];
+  size_t mIRPartitions[kMaxIRs] = {};
+  // Per IR accumulators, then the mix for one output.
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Scratch> mAccumulator[kMaxIRs];
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Scratch> mMix;
+};
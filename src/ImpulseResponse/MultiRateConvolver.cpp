@@ -0,0 +1,127 @@
+//
+//  MultiRateConvolver.cpp
+//
+//  Reduced-rate convolution of an IR tail.
+//
+
+#include "MultiRateConvolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FirKernel.h"
+
+
+namespace
+{
+// Blackman-windowed sinc lowpass at `cutoff` cycles/sample, unity DC gain.
+void _DesignLowpass(float* taps, size_t numTaps, double cutoff)
+{
+  const double pi = 3.14159265358979323846;
+  const double center = 0.5 * (double)(numTaps - 1);
+  double sum = 0.0;
+  for (size_t k = 0; k < numTaps; k++)
+  {
+    const double t = (double)k - center;
+    const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t);
+    const double phase = 2.0 * pi * (double)k / (double)(numTaps - 1);
+    const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+    taps[k] = (float)(sinc * window);
+    sum += taps[k];
+  }
+  for (size_t k = 0; k < numTaps; k++)
+    taps[k] = (float)(taps[k] / sum);
+}
+} // namespace
+
+
+MultiRateConvolver::MultiRateConvolver()
+{
+}
+
+// Destructor
+MultiRateConvolver::~MultiRateConvolver()
+{
+    // No Code Needed
+}
+
+
+void MultiRateConvolver::Ring::Init(size_t length)
+{
+  size = std::max<size_t>(length, 1);
+  buffer.assign(2 * size, 0.0f);
+  position = 0;
+}
+
+void MultiRateConvolver::Ring::Clear()
+{
+  std::fill(buffer.begin(), buffer.end(), 0.0f);
+  position = 0;
+}
+
+void MultiRateConvolver::Ring::Push(float sample)
+{
+  position = (position + 1 == size) ? 0 : position + 1;
+  buffer[position] = sample;
+  buffer[position + size] = sample;
+}
+
+void MultiRateConvolver::Reset()
+{
+  mInput.Clear();
+  mDecimated.Clear();
+  mOutput.Clear();
+  mPhase = 0;
+}
+
+void MultiRateConvolver::Init(const float* tailData, size_t tailLength, size_t rate, size_t split)
+{
+  mRate = std::max<size_t>(rate, 1);
+  mPhase = 0;
+  const size_t latency = Latency(mRate);
+  mTailDelay = split > latency ? (split - latency) / mRate : 0;
+
+  // Both filters cut off a little below the decimated Nyquist frequency.
+  const size_t filterTaps = latency + 1;
+  const double cutoff = 0.45 / (double)mRate;
+  IRMemory::Vector<float, IRMemory::Use::Scratch> lowpass(filterTaps);
+  _DesignLowpass(lowpass.data(), filterTaps, cutoff);
+
+  // It's symmetric, so time reversal is a no-op for the decimator.
+  mDecimator.assign(lowpass.begin(), lowpass.end());
+
+  // Interpolator phase p holds taps p, p + rate, p + 2 * rate, ... scaled by
+  // the rate to make up for the zeros the upsampling would have inserted.
+  mPhaseLength = (filterTaps + mRate - 1) / mRate;
+  mInterpolator.assign(mPhaseLength * mRate, 0.0f);
+  for (size_t p = 0; p < mRate; p++)
+    for (size_t j = 0; j < mPhaseLength; j++)
+    {
+      const size_t k = p + j * mRate;
+      if (k < filterTaps)
+        mInterpolator[p * mPhaseLength + (mPhaseLength - 1 - j)] = lowpass[k] * (float)mRate;
+    }
+
+  mTail.resize(std::max<size_t>(tailLength, 1));
+  mTail[0] = 0.0f;
+  for (size_t i = 0; i < tailLength; i++)
+    mTail[tailLength - 1 - i] = tailData[i];
+
+  mInput.Init(filterTaps);
+  mDecimated.Init(mTail.size() + mTailDelay);
+  mOutput.Init(mPhaseLength);
+}
+
+float MultiRateConvolver::Process(float input)
+{
+  mInput.Push(input);
+  if (++mPhase == mRate)
+  {
+    // One decimated sample in, one tail output sample out
+    mPhase = 0;
+    mDecimated.Push(FirKernel::Dot(mDecimator.data(), mInput.Window(mDecimator.size()), mDecimator.size()));
+    mOutput.Push(FirKernel::Dot(mTail.data(), mDecimated.Window(mTail.size(), mTailDelay), mTail.size()));
+  }
+  // Output phase mPhase of the interpolator over the decimated outputs
+  return FirKernel::Dot(&mInterpolator[mPhase * mPhaseLength], mOutput.Window(mPhaseLength), mPhaseLength);
+}
@@ -0,0 +1,94 @@
+//
+//  MultiRateConvolver.h
+//
+//  Reduced-rate convolution of an IR tail, for pairing with a full-rate
+//  direct-form head. Late reflections carry little high-frequency energy,
+//  so the tail runs at 1/2 or 1/4 of the sample rate: the input is
+//  decimated by a polyphase anti-alias filter, convolved with a decimated
+//  copy of the tail, and brought back up by a polyphase interpolator.
+//
+//  wav_to_ir_header.py --multirate produces the split: the head is the IR
+//  up to the split point plus a short fade-out, the tail starts at the split
+//  with the complementary fade-in and is lowpassed and decimated offline
+//  (scaled by the rate, see below). The two overlap over the fade, so the
+//  crossfade at the split is part of the data.
+//
+//  Cost per sample is about tailLength / rate + 2 * kFilterTapsPerRate MACs
+//  for tailLength decimated taps, i.e. 1/rate^2 of the full-rate tail.
+//  The filters delay the path by Latency(rate) samples, which comes out of
+//  the tail's own offset, so the split must be at least that far in.
+//
+
+#pragma once
+
+#include <cstddef>
+
+#include "IRMemory.h"
+
+
+class MultiRateConvolver
+{
+public:
+  // Anti-alias and anti-image filters have kFilterTapsPerRate * rate + 1
+  // taps, so each costs kFilterTapsPerRate MACs per full-rate sample.
+  static constexpr size_t kFilterTapsPerRate = 16;
+
+  MultiRateConvolver();
+  ~MultiRateConvolver();
+
+  // Full-rate delay of the decimate/interpolate path.
+  static size_t Latency(size_t rate) { return kFilterTapsPerRate * rate; }
+
+  // Prepare for a tail of `tailLength` decimated taps at 1/`rate` of the
+  // sample rate (2 or 4), starting `split` full-rate samples into the IR.
+  // Tap m stands for full-rate offset split + rate * m and is scaled by
+  // `rate`. `split` must be a multiple of `rate` and at least Latency(rate).
+  void Init(const float* tailData, size_t tailLength, size_t rate, size_t split);
+
+  // Clear the filter and tail state, keeping the IR.
+  void Reset();
+
+  // Push one input sample and return the tail's contribution to the output
+  // for that same sample.
+  float Process(float input);
+
+  size_t Rate() const { return mRate; }
+
+private:
+  // Ring written twice (at i and i + size) so the most recent samples are
+  // always contiguous, oldest first.
+  struct Ring
+  {
+    IRMemory::Vector<float, IRMemory::Use::History> buffer;
+    size_t size = 0;
+    size_t position = 0;
+
+    void Init(size_t length);
+    void Clear();
+    void Push(float sample);
+    // `length` samples, oldest first, ending `delay` samples before the newest.
+    const float* Window(size_t length, size_t delay = 0) const
+    {
+      return &buffer[position + size + 1 - delay - length];
+    }
+  };
+
+  size_t mRate = 0;
+  // Input samples until the next decimated sample, in [0, mRate).
+  size_t mPhase = 0;
+  // Delay of the decimated tail beyond the filter latency, in decimated samples.
+  size_t mTailDelay = 0;
+
+  // Time-reversed anti-alias filter, unity gain.
+  IRMemory::Vector<float, IRMemory::Use::Weights> mDecimator;
+  // Time-reversed decimated tail.
+  IRMemory::Vector<float, IRMemory::Use::Weights> mTail;
+  // Anti-image filter split into mRate time-reversed phases of
+  // mPhaseLength taps each, gain mRate.
+  IRMemory::Vector<float, IRMemory::Use::Weights> mInterpolator;
+  size_t mPhaseLength = 0;
+
+  Ring mInput;     // Full rate, for the decimator
+  Ring mDecimated; // Decimated input, for the tail
+  Ring mOutput;    // Decimated tail output, for the interpolator
+};
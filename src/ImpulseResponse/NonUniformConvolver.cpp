@@ -0,0 +1,96 @@
+//
+//  NonUniformConvolver.cpp
+//
+//  Non-uniformly partitioned convolution of an IR tail.
+//
+
+#include "NonUniformConvolver.h"
+
+#include <algorithm>
+
+
+NonUniformConvolver::NonUniformConvolver()
+{
+}
+
+// Destructor
+NonUniformConvolver::~NonUniformConvolver()
+{
+    // No Code Needed
+}
+
+
+void NonUniformConvolver::Init(const float* irData, size_t irLength, size_t firstPartitionSize,
+                               size_t maxPartitionSize)
+{
+  // Work out the layout first so the stages are allocated once.
+  size_t numStages = 0;
+  for (size_t size = firstPartitionSize, offset = HeadLength(firstPartitionSize); offset < irLength;
+       offset += 2 * size, size *= 2)
+  {
+    numStages++;
+    if (size >= maxPartitionSize)
+      break;
+  }
+
+  mStages.clear();
+  mStages.resize(numStages);
+
+  size_t size = firstPartitionSize;
+  size_t offset = HeadLength(firstPartitionSize);
+  for (Stage& stage : mStages)
+  {
+    // Every stage but the last covers exactly two partitions.
+    const bool last = (&stage == &mStages.back());
+    const size_t length = last ? irLength - offset : std::min(2 * size, irLength - offset);
+
+    stage.convolver.Init(irData + offset, length, size);
+    stage.input.assign(size, 0.0f);
+    stage.output.assign(size, 0.0f);
+    stage.position = 0;
+    stage.stepsDone = 0;
+
+    offset += 2 * size;
+    size *= 2;
+  }
+}
+
+void NonUniformConvolver::Reset()
+{
+  for (Stage& stage : mStages)
+  {
+    stage.convolver.Reset();
+    std::fill(stage.input.begin(), stage.input.end(), 0.0f);
+    std::fill(stage.output.begin(), stage.output.end(), 0.0f);
+    stage.position = 0;
+    stage.stepsDone = 0;
+  }
+}
+
+float NonUniformConvolver::Process(float input)
+{
+  float output = 0.0f;
+  for (Stage& stage : mStages)
+  {
+    const size_t size = stage.input.size();
+    output += stage.output[stage.position];
+    stage.input[stage.position] = input;
+    stage.position++;
+
+    // Keep the in-flight frame on schedule: by the end of this frame all of
+    // its steps must have run, so run them in proportion to elapsed samples.
+    const size_t target = stage.position * stage.convolver.NumSteps() / size;
+    for (; stage.stepsDone < target; stage.stepsDone++)
+      stage.convolver.Step();
+
+    if (stage.position == size)
+    {
+      const float* result = stage.convolver.FrameOutput();
+      std::copy(result, result + size, stage.output.begin());
+      stage.convolver.BeginFrame(stage.input.data());
+      stage.position = 0;
+      stage.stepsDone = 0;
+    }
+  }
+  return output;
+}
@@ -0,0 +1,64 @@
+//
+//  NonUniformConvolver.h
+//
+//  Non-uniformly partitioned convolution of an IR tail, for pairing with a
+//  short direct-form head so the combined output has no added latency.
+//
+//  The tail is covered by stages of growing partition size S: S0, 2*S0, ...
+//  up to a maximum, each stage holding two partitions, then a final uniform
+//  stage at the maximum size for whatever remains. A stage with partition
+//  size S starts at IR offset 2*S, which buys it one block to collect input
+//  and one block to compute, so its work is spread evenly over S samples
+//  instead of landing in a single audio callback. The work is counted in
+//  PartitionedConvolver steps of about S complex operations each, with the
+//  FFTs split into their butterfly passes, so no sample carries more than
+//  about one step per stage.
+//
+//  Layout for S0 = 16, max = 256:
+//    [0, 32) head | [32, 64) S=16 | [64, 128) S=32 | ... | [512, end) S=256
+//
+
+#pragma once
+
+#include <vector>
+
+#include "IRMemory.h"
+#include "PartitionedConvolver.h"
+
+
+class NonUniformConvolver
+{
+public:
+  NonUniformConvolver();
+  ~NonUniformConvolver();
+
+  // Prepare the stages for irData[HeadLength(), irLength).
+  // Partition sizes must be powers of two with firstPartitionSize <= maxPartitionSize.
+  void Init(const float* irData, size_t irLength, size_t firstPartitionSize, size_t maxPartitionSize);
+
+  // Number of leading IR taps *not* covered; the caller convolves these directly.
+  static size_t HeadLength(size_t firstPartitionSize) { return 2 * firstPartitionSize; }
+
+  // Clear every stage's input, output and frame in flight, keeping the IR.
+  void Reset();
+
+  // Push one input sample and return the tail's contribution to the output
+  // for that same sample.
+  float Process(float input);
+
+private:
+  struct Stage
+  {
+    PartitionedConvolver convolver;
+    // Input collected for the next frame.
+    IRMemory::Vector<float, IRMemory::Use::Scratch> input;
+    // Result of the frame before last, being played out.
+    IRMemory::Vector<float, IRMemory::Use::Scratch> output;
+    // Position within the current frame, in [0, partition size).
+    size_t position = 0;
+    // Steps of the in-flight frame that have been run.
+    size_t stepsDone = 0;
+  };
+
+  std::vector<Stage> mStages;
+};
@@ -0,0 +1,97 @@
+//
+//  PartitionedConvolver.cpp
+//
+//  Uniformly partitioned overlap-save (UPOLS) convolution.
+//
+
+#include "PartitionedConvolver.h"
+
+#include <algorithm>
+
+
+PartitionedConvolver::PartitionedConvolver()
+{
+}
+
+// Destructor
+PartitionedConvolver::~PartitionedConvolver()
+{
+    // No Code Needed
+}
+
+
+void PartitionedConvolver::Init(const float* irData, size_t irLength, size_t partitionSize)
+{
+  _Allocate(FrequencyDelayLine::NumPartitions(irLength, partitionSize), partitionSize);
+  mInput.TransformIR(irData, irLength, mIRSpectra.data());
+}
+
+void PartitionedConvolver::Init(const std::complex<float>* irSpectra, size_t numPartitions, size_t partitionSize)
+{
+  _Allocate(std::max<size_t>(1, numPartitions), partitionSize);
+  std::copy(irSpectra, irSpectra + numPartitions * mNumBins, mIRSpectra.begin());
+}
+
+void PartitionedConvolver::_Allocate(size_t numPartitions, size_t partitionSize)
+{
+  mPartitionSize = partitionSize;
+  mNumPartitions = numPartitions;
+
+  mInput.Init(partitionSize, numPartitions);
+  mNumBins = mInput.NumBins();
+
+  mIRSpectra.assign(mNumPartitions * mNumBins, std::complex<float>(0.0f, 0.0f));
+  mAccumulator.assign(mNumBins, std::complex<float>(0.0f, 0.0f));
+  mStep = NumSteps();
+}
+
+void PartitionedConvolver::Reset()
+{
+  mInput.Reset();
+  std::fill(mAccumulator.begin(), mAccumulator.end(), std::complex<float>(0.0f, 0.0f));
+  mStep = NumSteps();
+}
+
+void PartitionedConvolver::Process(const float* input, float* output)
+{
+  BeginFrame(input);
+  while (!FrameDone())
+    Step();
+  const float* result = FrameOutput();
+  std::copy(result, result + mPartitionSize, output);
+}
+
+void PartitionedConvolver::BeginFrame(const float* input)
+{
+  mInput.Push(input);
+  mStep = 0;
+}
+
+void PartitionedConvolver::Step()
+{
+  // [0, F) forward FFT | [F, F + partitions) MACs | [.., + F) inverse FFT
+  const size_t fftSteps = mInput.FFTSteps();
+  const size_t macEnd = fftSteps + mNumPartitions;
+  if (mStep < fftSteps)
+  {
+    mInput.ForwardStep(mStep);
+    if (mStep == fftSteps - 1)
+      std::fill(mAccumulator.begin(), mAccumulator.end(), std::complex<float>(0.0f, 0.0f));
+  }
+  else if (mStep < macEnd)
+  {
+    // Complex multiply-accumulate one partition against its delayed input.
+    mInput.Accumulate(mAccumulator.data(), mIRSpectra.data(), mStep - fftSteps, 1);
+  }
+  else if (mStep < macEnd + fftSteps)
+  {
+    mInput.InverseStep(mStep - macEnd, mAccumulator.data());
+    if (mStep == macEnd + fftSteps - 1)
+      mInput.Advance();
+  }
+  else
+  {
+    return;
+  }
+  mStep++;
+}
@@ -0,0 +1,73 @@
+//
+//  PartitionedConvolver.h
+//
+//  Uniformly partitioned overlap-save (UPOLS) convolution.
+//
+//  The IR is split into partitions of one audio block each. Every block the
+//  last two input blocks are transformed once, pushed into a frequency-domain
+//  delay line, and multiplied against every IR partition spectrum. One
+//  inverse transform then yields the block of output. Cost per sample is
+//  roughly (FFT + numPartitions complex MACs) / partitionSize instead of the
+//  full IR length. The input side is a FrequencyDelayLine.
+//
+
+#pragma once
+
+#include <complex>
+
+#include "FrequencyDelayLine.h"
+#include "IRMemory.h"
+
+
+class PartitionedConvolver
+{
+public:
+  PartitionedConvolver();
+  ~PartitionedConvolver();
+
+  // Transform the IR into partition spectra and clear all state.
+  // `partitionSize` must be a power of two.
+  void Init(const float* irData, size_t irLength, size_t partitionSize);
+  // Use partition spectra computed offline: numPartitions x NumBins() bins in
+  // the mIRSpectra layout, already scaled by 1/FFT size. Just a copy, no
+  // transforms.
+  void Init(const std::complex<float>* irSpectra, size_t numPartitions, size_t partitionSize);
+
+  // Clear the input and delay line, keeping the IR spectra.
+  void Reset();
+
+  // Process exactly PartitionSize() samples. `input` and `output` may alias.
+  void Process(const float* input, float* output);
+
+  // Time-distributed processing of the same work as Process(), so a large
+  // partition can be spread over several audio callbacks: BeginFrame()
+  // queues one block of input, then NumSteps() calls to Step() complete it.
+  // Each step costs about the same, PartitionSize() complex operations: the
+  // forward FFT's packing, butterfly passes and split, one complex MAC pass
+  // per partition, then the inverse FFT's in the same pieces.
+  // FrameOutput() holds PartitionSize() samples once FrameDone().
+  void BeginFrame(const float* input);
+  void Step();
+  bool FrameDone() const { return mStep == NumSteps(); }
+  size_t NumSteps() const { return mNumPartitions + 2 * mInput.FFTSteps(); }
+  const float* FrameOutput() const { return mInput.Output(); }
+
+  size_t PartitionSize() const { return mPartitionSize; }
+  size_t NumPartitions() const { return mNumPartitions; }
+
+private:
+  // Size every buffer and clear the state.
+  void _Allocate(size_t numPartitions, size_t partitionSize);
+
+  size_t mPartitionSize = 0;
+  size_t mNumPartitions = 0;
+  size_t mNumBins = 0;
+
+  FrequencyDelayLine mInput;
+  // IR partition spectra, mNumPartitions x mNumBins, pre-scaled by 1/FFT size.
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Spectra> mIRSpectra;
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Scratch> mAccumulator;
+
+  // Progress through the current frame, in [0, NumSteps()].
+  size_t mStep = 0;
+};
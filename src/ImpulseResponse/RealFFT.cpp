@@ -0,0 +1,163 @@
+//
+//  RealFFT.cpp
+//
+//  Radix-2 FFT for real signals, used by the partitioned convolution engine.
+//
+
+#include "RealFFT.h"
+
+#include <cmath>
+#include <utility>
+
+
+namespace
+{
+// Plain complex multiply. std::complex's operator* adds NaN/inf recovery
+// (__mulsc3) unless built with -ffast-math, which we don't want per bin.
+inline std::complex<float> _Mul(const std::complex<float>& a, const std::complex<float>& b)
+{
+  return std::complex<float>(a.real() * b.real() - a.imag() * b.imag(),
+                             a.real() * b.imag() + a.imag() * b.real());
+}
+
+inline std::complex<float> _MulConj(const std::complex<float>& a, const std::complex<float>& b)
+{
+  return std::complex<float>(a.real() * b.real() + a.imag() * b.imag(),
+                             a.imag() * b.real() - a.real() * b.imag());
+}
+} // namespace
+
+
+RealFFT::RealFFT()
+{
+}
+
+// Destructor
+RealFFT::~RealFFT()
+{
+    // No Code Needed
+}
+
+
+void RealFFT::Init(size_t size)
+{
+  mSize = size;
+  mHalfSize = size / 2;
+
+  size_t bits = 0;
+  while (((size_t)1 << bits) < mHalfSize)
+    bits++;
+  mNumPasses = bits;
+
+  mBitReverse.resize(mHalfSize);
+  for (size_t i = 0; i < mHalfSize; i++)
+  {
+    size_t r = 0;
+    for (size_t b = 0; b < bits; b++)
+      if (i & ((size_t)1 << b))
+        r |= (size_t)1 << (bits - 1 - b);
+    mBitReverse[i] = r;
+  }
+
+  const double pi = 3.14159265358979323846;
+  mTwiddle.resize(mHalfSize / 2);
+  for (size_t k = 0; k < mTwiddle.size(); k++)
+  {
+    const double a = -2.0 * pi * (double)k / (double)mHalfSize;
+    mTwiddle[k] = std::complex<float>((float)std::cos(a), (float)std::sin(a));
+  }
+
+  mSplitTwiddle.resize(mHalfSize);
+  for (size_t k = 0; k < mSplitTwiddle.size(); k++)
+  {
+    const double a = -2.0 * pi * (double)k / (double)mSize;
+    mSplitTwiddle[k] = std::complex<float>((float)std::cos(a), (float)std::sin(a));
+  }
+
+  mWork.resize(mHalfSize);
+}
+
+void RealFFT::Forward(const float* input, std::complex<float>* output)
+{
+  BeginForward(input);
+  for (size_t pass = 0; pass < mNumPasses; pass++)
+    Pass(pass, false);
+  EndForward(output);
+}
+
+void RealFFT::Inverse(const std::complex<float>* input, float* output)
+{
+  BeginInverse(input);
+  for (size_t pass = 0; pass < mNumPasses; pass++)
+    Pass(pass, true);
+  EndInverse(output);
+}
+
+void RealFFT::BeginForward(const float* input)
+{
+  // Pack even/odd samples as real/imaginary parts of a half-size signal.
+  for (size_t i = 0; i < mHalfSize; i++)
+    mWork[mBitReverse[i]] = std::complex<float>(input[2 * i], input[2 * i + 1]);
+}
+
+void RealFFT::EndForward(std::complex<float>* output)
+{
+  // Split the half-size spectrum back into the spectrum of the real signal.
+  const std::complex<float> z0 = mWork[0];
+  output[0] = std::complex<float>(z0.real() + z0.imag(), 0.0f);
+  output[mHalfSize] = std::complex<float>(z0.real() - z0.imag(), 0.0f);
+  for (size_t k = 1; k < mHalfSize; k++)
+  {
+    const std::complex<float> zk = mWork[k];
+    const std::complex<float> zc = std::conj(mWork[mHalfSize - k]);
+    const std::complex<float> even = 0.5f * (zk + zc);
+    const std::complex<float> diff = zk - zc;
+    // odd = -0.5i * (zk - zc)
+    const std::complex<float> odd(0.5f * diff.imag(), -0.5f * diff.real());
+    output[k] = even + _Mul(mSplitTwiddle[k], odd);
+  }
+}
+
+void RealFFT::BeginInverse(const std::complex<float>* input)
+{
+  // Rebuild the half-size spectrum (scaled by 2) from the real spectrum.
+  for (size_t k = 0; k < mHalfSize; k++)
+  {
+    const std::complex<float> xk = input[k];
+    const std::complex<float> xc = std::conj(input[mHalfSize - k]);
+    const std::complex<float> even = xk + xc;
+    const std::complex<float> odd = _MulConj(xk - xc, mSplitTwiddle[k]);
+    // even + i * odd
+    mWork[mBitReverse[k]] = std::complex<float>(even.real() - odd.imag(), even.imag() + odd.real());
+  }
+}
+
+void RealFFT::EndInverse(float* output)
+{
+  for (size_t i = 0; i < mHalfSize; i++)
+  {
+    output[2 * i] = mWork[i].real();
+    output[2 * i + 1] = mWork[i].imag();
+  }
+}
+
+void RealFFT::Pass(size_t pass, bool inverse)
+{
+  // Iterative decimation-in-time; Begin*() left the input in bit-reversed
+  // order. Pass p combines transforms of length 2^p into 2^(p + 1).
+  std::complex<float>* a = mWork.data();
+  const size_t len = (size_t)2 << pass;
+  const size_t half = len / 2;
+  const size_t step = mHalfSize / len;
+  for (size_t i = 0; i < mHalfSize; i += len)
+  {
+    for (size_t j = 0; j < half; j++)
+    {
+      const std::complex<float> w = inverse ? std::conj(mTwiddle[j * step]) : mTwiddle[j * step];
+      const std::complex<float> u = a[i + j];
+      const std::complex<float> v = _Mul(a[i + j + half], w);
+      a[i + j] = u + v;
+      a[i + j + half] = u - v;
+    }
+  }
+}
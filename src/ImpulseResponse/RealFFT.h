@@ -0,0 +1,64 @@
+//
+//  RealFFT.h
+//
+//  Radix-2 FFT for real signals, used by the partitioned convolution engine.
+//  A real transform of size N is computed as a complex transform of size N/2
+//  plus a split step, so only N/2 + 1 bins are produced/consumed.
+//
+//  Either transform can also be run in pieces of roughly N/2 complex
+//  operations each (packing, one butterfly pass per radix-2 stage, the
+//  split), so a large transform can be spread over several callbacks.
+//
+
+#pragma once
+
+#include <complex>
+
+#include "IRMemory.h"
+
+
+class RealFFT
+{
+public:
+  RealFFT();
+  ~RealFFT();
+
+  // Allocate tables for a transform of `size` real samples.
+  // `size` must be a power of two and at least 2.
+  void Init(size_t size);
+
+  size_t Size() const { return mSize; }
+  size_t NumBins() const { return mSize / 2 + 1; }
+
+  // Forward transform: `size` real samples -> NumBins() complex bins.
+  void Forward(const float* input, std::complex<float>* output);
+
+  // Inverse transform: NumBins() complex bins -> `size` real samples.
+  // Unnormalised: Inverse(Forward(x)) == size * x.
+  void Inverse(const std::complex<float>* input, float* output);
+
+  // Forward() in pieces: BeginForward(), Pass(0, false) ... Pass(NumPasses()
+  // - 1, false), EndForward(). Inverse() likewise, with `inverse` true. The
+  // input is read by Begin*() and the output written by End*(); one
+  // transform at a time may be in flight.
+  size_t NumPasses() const { return mNumPasses; }
+  void BeginForward(const float* input);
+  void EndForward(std::complex<float>* output);
+  void BeginInverse(const std::complex<float>* input);
+  void EndInverse(float* output);
+  // Butterfly stage `pass` of the complex transform, in place on mWork.
+  void Pass(size_t pass, bool inverse);
+
+private:
+  size_t mSize = 0;
+  size_t mHalfSize = 0;
+  // log2(mHalfSize): butterfly stages per transform.
+  size_t mNumPasses = 0;
+  // Bit-reversed index for each of the mHalfSize complex points.
+  IRMemory::Vector<size_t, IRMemory::Use::Scratch> mBitReverse;
+  // exp(-2*pi*i*k / mHalfSize) for the complex butterflies.
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Scratch> mTwiddle;
+  // exp(-2*pi*i*k / mSize) for the real/complex split step.
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Scratch> mSplitTwiddle;
+  IRMemory::Vector<std::complex<float>, IRMemory::Use::Scratch> mWork;
+};
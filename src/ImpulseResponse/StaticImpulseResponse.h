@@ -0,0 +1,97 @@
+//
+//  StaticImpulseResponse.h
+//
+//  Direct-form IR convolution with every buffer sized at compile time.
+//
+//  ImpulseResponse sizes its weights and history per Init() from the heap,
+//  with runtime loop bounds; it stays the class to prototype new IR lengths
+//  and engines with. Once the IR length and audio block size are fixed, this
+//  variant holds the same direct-form state in member arrays:
+//
+//    * No allocation at all, so Init() is safe to call after boot.
+//    * The whole object can be placed with a section attribute, e.g.
+//        DSY_SDRAM_BSS static StaticImpulseResponse<8192, 8> ir;
+//    * MaxTaps and BlockSize are constexpr loop bounds in the kernel.
+//
+//  IRs shorter than MaxTaps are zero padded: the cost is always MaxTaps
+//  MACs per sample, so pick MaxTaps to match the IRs actually shipped.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "FirKernel.h"
+
+
+namespace StaticImpulseResponseDetail
+{
+constexpr size_t NextPowerOfTwo(size_t n)
+{
+  size_t p = 1;
+  while (p < n)
+    p <<= 1;
+  return p;
+}
+} // namespace StaticImpulseResponseDetail
+
+template <size_t MaxTaps, size_t BlockSize>
+class StaticImpulseResponse
+{
+public:
+  static_assert(MaxTaps > 0, "MaxTaps must be positive");
+  static_assert(BlockSize > 0 && BlockSize % 4 == 0, "BlockSize must be a multiple of 4");
+
+  // Mirrored history ring (see HistoryMode::Mirrored): a power of two that
+  // holds MaxTaps - 1 past samples plus one block.
+  static constexpr size_t kRingSize = StaticImpulseResponseDetail::NextPowerOfTwo(MaxTaps - 1 + BlockSize);
+
+  StaticImpulseResponse() {}
+  // Destructor
+  ~StaticImpulseResponse()
+  {
+    // No Code Needed
+  }
+
+  // Copy the first min(irLength, MaxTaps) taps and clear the history.
+  void Init(const float* irData, size_t irLength)
+  {
+    mLength = std::min(irLength, MaxTaps);
+    // Time-reversed for FirKernel, zero padded at the front so the newest
+    // sample still lines up with the last weight.
+    std::fill(mWeight, mWeight + MaxTaps, 0.0f);
+    for (size_t i = 0; i < mLength; i++)
+      mWeight[MaxTaps - 1 - i] = irData[i];
+    std::fill(mHistory, mHistory + 2 * kRingSize, 0.0f);
+    mHistoryIndex = 0;
+  }
+
+  // Process exactly BlockSize samples. `inputs` and `outputs` may alias.
+  void ProcessBlock(const float* inputs, float* outputs)
+  {
+    for (size_t i = 0; i < BlockSize; i++)
+    {
+      const size_t j = (mHistoryIndex + i) & (kRingSize - 1);
+      mHistory[j] = inputs[i];
+      mHistory[j + kRingSize] = inputs[i];
+    }
+
+    const size_t start = (mHistoryIndex + kRingSize - (MaxTaps - 1)) & (kRingSize - 1);
+    FirKernel::Convolve<MaxTaps, BlockSize>(mWeight, &mHistory[start], outputs);
+
+    mHistoryIndex = (mHistoryIndex + BlockSize) & (kRingSize - 1);
+  }
+
+  // Taps copied by the last Init().
+  size_t Length() const { return mLength; }
+
+private:
+  // The weights, time-reversed for FirKernel
+  alignas(32) float mWeight[MaxTaps];
+  // Ring of kRingSize samples written twice, so the window is contiguous.
+  alignas(32) float mHistory[2 * kRingSize];
+  // Ring write position of the next block.
+  size_t mHistoryIndex = 0;
+  size_t mLength = 0;
+};
@@ -9,36 +9,116 @@
 
 #include "dsp.h"
 
+#include "Trace.h"
 
-History::History()
+#include <algorithm>
+
+
+template <typename T>
+HistoryT<T>::HistoryT()
 {
 }
 
 // Destructor
-History::~History()
+template <typename T>
+HistoryT<T>::~HistoryT()
 {
     // No Code Needed
 }
 
 
-void History::_AdvanceHistoryIndex(const size_t bufferSize)
+template <typename T>
+void HistoryT<T>::_ResetHistory(const size_t historyRequired, const Mode mode, const size_t maxBlockSize)
 {
-  mHistoryIndex += bufferSize;
+  mHistoryRequired = historyRequired;
+  mHistoryMode = mode;
+
+  if (mHistoryMode == Mode::Mirrored)
+  {
+    // The ring must hold the window plus one block for the block's window
+    // to be contiguous in one of the two copies.
+    size_t ringSize = 1;
+    while (ringSize < mHistoryRequired + std::max<size_t>(maxBlockSize, 1))
+      ringSize <<= 1;
+    mHistoryMask = ringSize - 1;
+    mHistory.resize(2 * ringSize);
+    std::fill(mHistory.begin(), mHistory.end(), T(0));
+    mHistory.shrink_to_fit();
+    mHistoryIndex = 0;
+    return;
+  }
+
+  // Moved from HISTORY::EnsureHistorySize since only doing once for this module (assuming same size IR's)
+  const size_t requiredHistoryArraySize = std::max<size_t>(5 * mHistoryRequired, mHistoryRequired + 2); // Just so we don't spend too much time copying back. // KAB NOTE: was 10 *
+  mHistory.resize(requiredHistoryArraySize);
+  std::fill(mHistory.begin(), mHistory.end(), T(0));
+  mHistoryIndex = mHistoryRequired;
 }
 
+template <typename T>
+void HistoryT<T>::_ClearHistory()
+{
+  std::fill(mHistory.begin(), mHistory.end(), T(0));
+  mHistoryIndex = mHistoryMode == Mode::Mirrored ? 0 : mHistoryRequired;
+}
 
-void History::_RewindHistory()
+template <typename T>
+void HistoryT<T>::_AdvanceHistoryIndex(const size_t bufferSize)
 {
-  // TODO memcpy?  Should be fine w/ history array being >2x the history length.
-  for (size_t i = 0, j = mHistoryIndex - mHistoryRequired; i < mHistoryRequired; i++, j++)
-    mHistory[i] = mHistory[j];
+  if (mHistoryMode == Mode::Mirrored)
+    mHistoryIndex = (mHistoryIndex + bufferSize) & mHistoryMask;
+  else
+    mHistoryIndex += bufferSize;
+}
+
+
+template <typename T>
+void HistoryT<T>::_RewindHistory()
+{
+  Trace::Scope trace(Trace::Event::HistoryRewind);
+  // A forward copy is safe even if the ranges overlap: the destination
+  // starts first. The Mirrored mode never gets here.
+  std::copy(mHistory.begin() + (mHistoryIndex - mHistoryRequired), mHistory.begin() + mHistoryIndex,
+            mHistory.begin());
   mHistoryIndex = mHistoryRequired;
 }
 
-void History::_UpdateHistory(float inputs)
+template <typename T>
+void HistoryT<T>::_UpdateHistory(T inputs)
 {
+  if (mHistoryMode == Mode::Mirrored)
+  {
+    mHistory[mHistoryIndex] = inputs;
+    mHistory[mHistoryIndex + mHistoryMask + 1] = inputs;
+    return;
+  }
+
   if (mHistoryIndex + 1 >= mHistory.size())
     _RewindHistory();
 
   mHistory[mHistoryIndex] = inputs;
 }
+
+template <typename T>
+void HistoryT<T>::_UpdateHistory(const T* inputs, const size_t numFrames)
+{
+  if (mHistoryMode == Mode::Mirrored)
+  {
+    const size_t ringSize = mHistoryMask + 1;
+    for (size_t i = 0, j = mHistoryIndex; i < numFrames; i++, j = (j + 1) & mHistoryMask)
+    {
+      mHistory[j] = inputs[i];
+      mHistory[j + ringSize] = inputs[i];
+    }
+    return;
+  }
+
+  if (mHistoryIndex + numFrames >= mHistory.size())
+    _RewindHistory();
+
+  std::copy(inputs, inputs + numFrames, mHistory.begin() + mHistoryIndex);
+}
+
+template class HistoryT<float>;
+template class HistoryT<int16_t>;
+template class HistoryT<int32_t>;
@@ -1,37 +1,88 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "IRMemory.h"
+
+// How a history array is laid out.
+enum class HistoryMode
+{
+  // Linear buffer several times the history length. When it fills, the
+  // last mHistoryRequired samples are copied back to the front.
+  Linear,
+  // Power-of-two ring written twice (at i and i + N), so the window ending
+  // at the newest sample is always contiguous and nothing is ever copied.
+  Mirrored,
+};
 
 // A class where a longer buffer of history is needed to correctly calculate
 // the DSP algorithm (e.g. algorithms involving convolution).
 //
 // Hacky stuff:
 // * Mono
-// * Single-precision floats.
-class History
+// * Sample type is a template parameter: float, or int16_t/int32_t for the
+//   fixed-point paths. Only those three are instantiated.
+template <typename T>
+class HistoryT
 {
 public:
-  History();
-  ~History();
+  using Mode = HistoryMode;
+
+  HistoryT();
+  ~HistoryT();
 protected:
+  // Size and clear the history for `historyRequired` past samples, with
+  // blocks of up to `maxBlockSize` samples (Mirrored mode sizes the ring from
+  // this; larger blocks still work but are split by the caller).
+  void _ResetHistory(const size_t historyRequired, const Mode mode, const size_t maxBlockSize);
+  // Zero the history, keeping its size and layout.
+  void _ClearHistory();
   // Called at the end of the DSP, advance the hsitory index to the next open
   // spot.  Does not ensure that it's at a valid address.
   void _AdvanceHistoryIndex(const size_t bufferSize);
   // Drop the new samples into the history array.
   // Manages history array size
-  void _UpdateHistory(float inputs);
+  void _UpdateHistory(T inputs);
+  // Block version: drop `numFrames` samples in, starting at mHistoryIndex.
+  // The rewind check runs once for the whole block.
+  // numFrames must not exceed _MaxHistoryBlock().
+  void _UpdateHistory(const T* inputs, const size_t numFrames);
+  // Largest block _UpdateHistory() can take in one call.
+  size_t _MaxHistoryBlock() const
+  {
+    return mHistoryMode == Mode::Mirrored ? mHistoryMask + 1 - mHistoryRequired
+                                          : mHistory.size() - mHistoryRequired - 1;
+  }
+  // Contiguous window starting mHistoryRequired samples before the first
+  // sample of the last update, i.e. the oldest input needed for its output.
+  const T* _HistoryWindow() const
+  {
+    if (mHistoryMode == Mode::Linear)
+      return &mHistory[mHistoryIndex - mHistoryRequired];
+    // Read from the mirror when the window would start before the ring.
+    const size_t start = mHistoryIndex >= mHistoryRequired ? mHistoryIndex - mHistoryRequired
+                                                           : mHistoryIndex + mHistoryMask + 1 - mHistoryRequired;
+    return &mHistory[start];
+  }
 
   // The history array that's used for DSP calculations.
-  std::vector<float> mHistory;
+  IRMemory::Vector<T, IRMemory::Use::History> mHistory;
   // How many samples previous are required.
   // Zero means that no history is required--only the current sample.
   size_t mHistoryRequired = 0;
   // Location of the first sample in the current buffer.
-  // Shall always be in the range [mHistoryRequired, mHistory.size()).
+  // Linear: shall always be in the range [mHistoryRequired, mHistory.size()).
+  // Mirrored: the ring write position, in [0, N).
   size_t mHistoryIndex = 0;
+  Mode mHistoryMode = Mode::Mirrored;
+  // Mirrored: ring length N - 1 (N is a power of two, mHistory holds 2N).
+  size_t mHistoryMask = 0;
 
 private:
 
   // Copy the end of the history back to the front and reset mHistoryIndex
   void _RewindHistory();
 };
+
+using History = HistoryT<float>;
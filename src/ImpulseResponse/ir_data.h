@@ -7,20 +7,47 @@
 #define IR_DATA_H
 
 #include <cstddef>
+#include <cstdint>
 
 namespace ImpulseResponseData {
 
+// What IRInfo::spectra holds
+enum class IRFormat : uint8_t {
+    Raw,                 // Time-domain data only
+    PartitionedSpectra,  // Plus pre-transformed partitions for the partitioned engine
+};
+
+// Compressed copy in IRInfo::packed (see BlockFloat.h)
+enum class IRCodec : uint8_t {
+    None,
+    BlockFloat8,   // 8-bit mantissas, 8.5 bits per tap
+    BlockFloat16,  // 16-bit mantissas, 17 bits per tap
+};
+
 // IR metadata
 struct IRInfo {
     const char* name;
-    const float* data;  // Pointer to QSPI data
+    const float* data;  // Pointer to QSPI data (nullptr if not generated)
     size_t length;      // Sample count
+    const int16_t* q15; // Optional Q15 copy in QSPI (nullptr if not generated)
+    const int32_t* q31; // Optional Q31 copy in QSPI (nullptr if not generated)
+    int qShift;         // Fixed-point weight = q * 2^-(15 or 31 + qShift)
+    IRFormat format;
+    const float* spectra;  // Interleaved re/im, partitions x (partitionSize + 1) bins
+    size_t partitionSize;  // Partition size the spectra were computed for
+    IRCodec codec;
+    const uint8_t* packed; // Compressed copy in QSPI (nullptr if not generated)
+    // Multi-rate tail (see MultiRateConvolver.h); data/length are then the head.
+    const float* tail;     // nullptr if not generated
+    size_t tailLength;     // Decimated taps
+    size_t tailRate;       // Decimation factor
+    size_t tailSplit;      // Full-rate offset of the first tail tap
 };
 
-// IR: v30 (8160 samples, 170.0ms)
+// IR: v30 (8151 samples, 169.8ms)
 // Stored in QSPI flash
 __attribute__((section(".qspiflash_data"))) __attribute__((aligned(4)))
-const float v30[8160] = {
+const float v30[8151] = {
     0.00040448f, 0.00036263f, 0.00512683f, 0.00783813f, 0.01512051f, 0.02670467f, 0.06139362f, 0.13686979f,
     0.28482592f, 0.50676191f, 0.80344725f, 0.97999990f, 0.96870708f, 0.72450781f, 0.31733072f, -0.08954692f,
     -0.37616253f, -0.51128578f, -0.44207621f, -0.21147478f, -0.01019347f, 0.18734884f, 0.24319315f, 0.18525636f,
@@ -1027,27 +1054,26 @@ const float v30[8160] = {
     0.00006056f, -0.00005329f, -0.00010765f, -0.00010753f, -0.00004911f, 0.00003648f, 0.00007522f, 0.00006795f,
     -0.00001216f, -0.00014412f, -0.00025070f, -0.00028217f, -0.00024867f, -0.00014985f, -0.00005746f, -0.00003850f,
     -0.00010943f, -0.00025666f, -0.00044775f, -0.00059688f, -0.00065482f, -0.00060415f, -0.00046980f, -0.00026333f,
-    -0.00005257f, 0.00012040f, 0.00020254f, 0.00019598f, 0.00010335f, -0.00002921f, -0.00017059f, -0.00025833f,
-    -0.00025547f, -0.00017691f, -0.00004506f, 0.00009799f, 0.00023353f, 0.00034487f, 0.00043213f, 0.00045836f,
-    0.00043368f, 0.00030971f, 0.00011241f, -0.00011015f, -0.00029147f, -0.00038230f, -0.00037003f, -0.00024939f,
-    -0.00005078f, 0.00019562f, 0.00042391f, 0.00060070f, 0.00066864f, 0.00063396f, 0.00051248f, 0.00033188f,
-    0.00013900f, -0.00004053f, -0.00016356f, -0.00022924f, -0.00023711f, -0.00023556f, -0.00022650f, -0.00021088f,
-    -0.00016403f, -0.00009549f, -0.00001836f, 0.00005472f, 0.00010478f, 0.00013280f, 0.00012660f, 0.00011849f,
-    0.00009966f, 0.00006604f, 0.00000286f, -0.00007701f, -0.00014615f, -0.00015986f, -0.00010073f, 0.00003982f,
-    0.00021422f, 0.00035667f, 0.00040007f, 0.00033629f, 0.00017405f, 0.00000072f, -0.00009871f, -0.00010777f,
-    -0.00003850f, 0.00010979f, 0.00027490f, 0.00042605f, 0.00053298f, 0.00052655f, 0.00040066f, 0.00016856f,
-    -0.00011349f, -0.00037384f, -0.00052929f, -0.00056314f, -0.00046921f, -0.00027680f, -0.00002992f, 0.00019991f,
-    0.00037897f, 0.00049174f, 0.00053728f, 0.00051641f, 0.00045657f, 0.00036418f, 0.00029063f, 0.00019789f,
-    0.00007904f, -0.00011158f, -0.00035405f, -0.00062323f, -0.00081170f, -0.00087476f, -0.00076282f, -0.00051236f,
-    -0.00025010f, -0.00006628f, -0.00006151f, -0.00023401f, -0.00047767f, -0.00065839f, -0.00071073f, -0.00055003f,
-    -0.00023663f, 0.00015497f, 0.00053346f, 0.00082934f, 0.00098443f, 0.00101972f, 0.00098789f, 0.00090897f
+    -0.00005257f, 0.00012040f, 0.00020254f, 0.00019598f, 0.00010335f, -0.00002921f, -0.00017059f, -0.00025826f,
+    -0.00025520f, -0.00017649f, -0.00004487f, 0.00009735f, 0.00023133f, 0.00034046f, 0.00042492f, 0.00044869f,
+    0.00042241f, 0.00029998f, 0.00010822f, -0.00010534f, -0.00027674f, -0.00036019f, -0.00034574f, -0.00023096f,
+    -0.00004659f, 0.00017768f, 0.00038098f, 0.00053386f, 0.00058731f, 0.00055000f, 0.00043889f, 0.00028039f,
+    0.00011578f, -0.00003326f, -0.00013217f, -0.00018229f, -0.00018541f, -0.00018102f, -0.00017093f, -0.00015618f,
+    -0.00011913f, -0.00006796f, -0.00001279f, 0.00003731f, 0.00006987f, 0.00008651f, 0.00008051f, 0.00007350f,
+    0.00006024f, 0.00003887f, 0.00000164f, -0.00004286f, -0.00007899f, -0.00008381f, -0.00005118f, 0.00001959f,
+    0.00010191f, 0.00016391f, 0.00017741f, 0.00014373f, 0.00007160f, 0.00000028f, -0.00003748f, -0.00003924f,
+    -0.00001342f, 0.00003659f, 0.00008743f, 0.00012912f, 0.00015365f, 0.00014413f, 0.00010393f, 0.00004135f,
+    -0.00002628f, -0.00008151f, -0.00010840f, -0.00010806f, -0.00008413f, -0.00004624f, -0.00000464f, 0.00002871f,
+    0.00005019f, 0.00005982f, 0.00005978f, 0.00005230f, 0.00004188f, 0.00003008f, 0.00002148f, 0.00001299f,
+    0.00000457f, -0.00000564f, -0.00001546f, -0.00002324f, -0.00002548f, -0.00002274f, -0.00001609f, -0.00000855f,
+    -0.00000320f, -0.00000062f, -0.00000040f, -0.00000098f, -0.00000113f, -0.00000069f, -0.00000019f
 };
 
 // Collection of all IRs for indexing (1 total)
 constexpr size_t IR_COUNT = 1;
 
 const IRInfo ir_collection[IR_COUNT] = {
-    {"v30", v30, 8160},
+    {"v30", v30, 8151, nullptr, nullptr, 0, IRFormat::Raw, nullptr, 0, IRCodec::None, nullptr, nullptr, 0, 0, 0},
 };
 
 }  // namespace ImpulseResponseData
@@ -0,0 +1,109 @@
+//
+//  OverloadGuard.cpp
+//
+//  Automatic IR length degradation when the audio callback can't keep up.
+//
+
+#include "OverloadGuard.h"
+
+
+OverloadGuard::OverloadGuard()
+{
+}
+
+// Destructor
+OverloadGuard::~OverloadGuard()
+{
+    // No Code Needed
+}
+
+
+void OverloadGuard::Init(uint32_t deadline, uint32_t now)
+{
+  mDeadline = deadline;
+  mAverageQ6 = 0;
+  mOverruns = 0;
+  mSeenOverruns = 0;
+  mIdleBlocks = 0;
+  mSeenIdleBlocks = 0;
+  mSwitchBlocks = 0;
+  mSeenSwitchBlocks = 0;
+  mStepUpMs = kStepUpMs;
+  _SetTier(mTier, now);
+}
+
+uint32_t OverloadGuard::LoadPermille() const
+{
+  const uint32_t average = mAverageQ6 >> 6;
+  return mDeadline > 0 ? (uint32_t)((uint64_t)average * 1000 / mDeadline) : 0;
+}
+
+bool OverloadGuard::Update(uint32_t now)
+{
+#if OVERLOAD_GUARD
+  const uint32_t overruns = mOverruns;
+  const bool missed = overruns != mSeenOverruns;
+  mSeenOverruns = overruns;
+  const uint32_t idleBlocks = mIdleBlocks;
+  const bool idle = idleBlocks != mSeenIdleBlocks;
+  mSeenIdleBlocks = idleBlocks;
+  const uint32_t switchBlocks = mSwitchBlocks;
+  const bool switching = switchBlocks != mSeenSwitchBlocks;
+  mSeenSwitchBlocks = switchBlocks;
+  const uint32_t load = LoadPermille();
+
+  if (now - mChangedAt < kSettleMs)
+  {
+    mBusySince = now;
+    return false;
+  }
+  // An IR switch runs both IRs until the old one has rung out. That says
+  // nothing about the steady load, so the interval is skipped, neither
+  // counting towards a step down nor restarting the wait for a step up.
+  if (switching)
+    return false;
+
+  // The average only follows blocks that convolved, so in silence it's stale
+  if (missed || (!idle && load > kOverloadPermille))
+  {
+    mBusySince = now;
+    if (++mOverloadIntervals < kStepDownIntervals)
+      return false;
+    // A step up that didn't hold: wait longer before the next one
+    if (mTryingUp)
+    {
+      mStepUpMs = mStepUpMs * 2 < kMaxStepUpMs ? mStepUpMs * 2 : kMaxStepUpMs;
+      mTryingUp = false;
+    }
+    if (mTier + 1 >= kNumTiers)
+      return false;
+    _SetTier(mTier + 1, now);
+    return true;
+  }
+  mOverloadIntervals = 0;
+
+  if (mTryingUp && now - mChangedAt >= kStepUpMs)
+    mTryingUp = false;
+
+  // Silence is cheap whatever the tier, so it can't vouch for a step up
+  if (idle || load > kStepUpPermille)
+    mBusySince = now;
+  if (mTier == 0 || now - mBusySince < mStepUpMs)
+    return false;
+  _SetTier(mTier - 1, now);
+  mTryingUp = true;
+  return true;
+#else
+  (void)now;
+  return false;
+#endif
+}
+
+void OverloadGuard::_SetTier(size_t tier, uint32_t now)
+{
+  mTier = tier;
+  mOverloadIntervals = 0;
+  mBusySince = now;
+  mChangedAt = now;
+  mTryingUp = false;
+}
@@ -0,0 +1,128 @@
+//
+//  OverloadGuard.h
+//
+//  Automatic IR length degradation when the audio callback can't keep up.
+//
+//  The callback hands its cycle count to Record() every block. The main loop
+//  calls Update() at a fixed interval: sustained overload (missed deadlines,
+//  or an average load near the deadline, for kStepDownIntervals intervals in
+//  a row) steps down one tier, halving the IR length the engines get. Once
+//  the load has stayed low enough for the next tier up to fit, for
+//  kStepUpMs of playing (silent blocks don't count), it steps back up. A
+//  step up that overloads again doubles the wait before the next try, so a
+//  marginal IR doesn't flap between tiers. Intervals with an IR switch in
+//  them, which runs two IRs for a while, aren't judged either way.
+//
+//  Only built in with OVERLOAD_GUARD=1 (the default). Otherwise the tier
+//  stays at full length and every call is an empty inline.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+#ifndef OVERLOAD_GUARD
+#define OVERLOAD_GUARD 1
+#endif
+
+
+class OverloadGuard
+{
+public:
+  // Tier 0 is the full IR, each tier after it half the length of the one
+  // before: 8192, 4096, 2048, 1024 taps.
+  static constexpr size_t kNumTiers = 4;
+  // Load, in tenths of a percent of the deadline, counted as overload.
+  static constexpr uint32_t kOverloadPermille = 900;
+  // Interval averages above kOverloadPermille, or with a missed deadline,
+  // needed in a row to step down.
+  static constexpr uint32_t kStepDownIntervals = 2;
+  // Load below which the next tier up, with up to twice the convolution
+  // work, still fits under kOverloadPermille.
+  static constexpr uint32_t kStepUpPermille = 400;
+  // Time at low load before stepping up, and its cap after failed tries.
+  static constexpr uint32_t kStepUpMs = 3000;
+  static constexpr uint32_t kMaxStepUpMs = 60000;
+  // After a tier change, time for the reload to reach the audio side. The
+  // switch after it is left out through Record()'s `switching`.
+  static constexpr uint32_t kSettleMs = 250;
+
+  OverloadGuard();
+  ~OverloadGuard();
+
+  // Deadline in cycles, one audio block (CpuProfiler::Deadline()). Call
+  // again when the block size changes; the tier is kept.
+  void Init(uint32_t deadline, uint32_t now);
+
+  // Cycles the last audio callback took. With `idle`, the callback skipped
+  // the convolution (IRManager::Idle()): its load says nothing about what
+  // playing costs, so it only counts towards missed deadlines. With
+  // `switching`, it ran two IRs (IRManager::Switching()), and its interval
+  // is left out. Call from the audio callback only.
+  void Record(uint32_t cycles, bool idle, bool switching)
+  {
+#if OVERLOAD_GUARD
+    if (cycles > mDeadline)
+      mOverruns = mOverruns + 1;
+    if (idle)
+    {
+      mIdleBlocks = mIdleBlocks + 1;
+      return;
+    }
+    if (switching)
+    {
+      mSwitchBlocks = mSwitchBlocks + 1;
+      return;
+    }
+    // average = 1/64 of the new value + 63/64 of the old, kept in 26.6
+    mAverageQ6 += (int32_t)cycles - (int32_t)(mAverageQ6 >> 6);
+#else
+    (void)cycles;
+    (void)idle;
+    (void)switching;
+#endif
+  }
+
+  // Evaluate the load since the last call, at most one tier step. Returns
+  // true when Tier() changed and the IR should be reloaded. Call from the
+  // main loop at a fixed interval; `now` in ms.
+  bool Update(uint32_t now);
+
+  size_t Tier() const { return mTier; }
+  // `length` capped to the current tier.
+  size_t MaxLength(size_t length) const
+  {
+    const size_t cap = kFullLength >> mTier;
+    return length < cap ? length : cap;
+  }
+  // Average callback load, in tenths of a percent of the deadline.
+  uint32_t LoadPermille() const;
+  // Callbacks that ran past the deadline since Init().
+  uint32_t Overruns() const { return mOverruns; }
+
+private:
+  static constexpr size_t kFullLength = 8192;
+
+  // Step to `tier` and restart the timers.
+  void _SetTier(size_t tier, uint32_t now);
+
+  uint32_t mDeadline = 0;
+  volatile uint32_t mAverageQ6 = 0;
+  volatile uint32_t mOverruns = 0;
+  uint32_t mSeenOverruns = 0;
+  volatile uint32_t mIdleBlocks = 0;
+  uint32_t mSeenIdleBlocks = 0;
+  volatile uint32_t mSwitchBlocks = 0;
+  uint32_t mSeenSwitchBlocks = 0;
+
+  size_t mTier = 0;
+  uint32_t mOverloadIntervals = 0;
+  // Since the load was last above kStepUpPermille, or the tier changed.
+  uint32_t mBusySince = 0;
+  uint32_t mChangedAt = 0;
+  uint32_t mStepUpMs = kStepUpMs;
+  // The last change was a step up, not yet proven by kStepUpMs of service.
+  bool mTryingUp = false;
+};
@@ -0,0 +1,199 @@
+//
+//  SettingsLog.h
+//
+//  Wear-levelled, append-only settings storage in a dedicated QSPI region.
+//
+//  Every save appends one checksummed record after the last one, and only
+//  a record that starts a new 4 KB sector costs an erase. The region wraps,
+//  so wear spreads over all of its sectors. On boot the newest valid record
+//  wins; a torn write just fails its checksum and the previous one is used.
+//
+//  Saves are debounced: Request() only stages the settings, and Process()
+//  writes them once they have been left alone for the save delay. The QSPI
+//  erase/program calls block and take the chip out of memory-mapped mode,
+//  so call Process() only when nothing reads QSPI (no IR transfer running);
+//  a save normally costs one page program, well under a millisecond.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "daisy_seed.h"
+
+
+template <typename T>
+class SettingsLog
+{
+public:
+  // QSPI erase granularity.
+  static constexpr uint32_t kSectorSize = 4096;
+
+  // `regionOffset` and `regionSize` are QSPI offsets in whole sectors, and
+  // must not overlap anything linked into .qspiflash_data.
+  SettingsLog(daisy::QSPIHandle& qspi, uint32_t regionOffset, uint32_t regionSize, uint32_t saveDelayMs)
+  : mQspi(qspi)
+  , mRegionOffset(regionOffset)
+  , mNumSectors(regionSize / kSectorSize)
+  , mSaveDelayMs(saveDelayMs)
+  {
+  }
+
+  // Find the newest valid record. Returns false, with Get() == defaults,
+  // when the region holds none.
+  bool Init(const T& defaults)
+  {
+    mSettings = defaults;
+    mStored = defaults;
+    mPending = false;
+    mSequence = 0;
+    mNextSlot = 0;
+
+    bool found = false;
+    for (uint32_t slot = 0; slot < NumSlots(); slot++)
+    {
+      Record record;
+      std::memcpy(&record, _Mapped(slot), sizeof(record));
+      if (record.magic != kMagic || record.checksum != _Checksum(record))
+        continue;
+      if (!found || record.sequence > mSequence)
+      {
+        found = true;
+        mSequence = record.sequence;
+        mNextSlot = slot + 1 == NumSlots() ? 0 : slot + 1;
+        mSettings = record.settings;
+      }
+    }
+    mStored = mSettings;
+    return found;
+  }
+
+  // Settings as last loaded or requested.
+  const T& Get() const { return mSettings; }
+
+  // Stage `settings` for saving; restarts the save delay from `now` (ms).
+  void Request(const T& settings, uint32_t now)
+  {
+    mSettings = settings;
+    mPending = mSettings != mStored;
+    mRequestTime = now;
+  }
+
+  // True once a staged save has waited out the delay.
+  bool SaveDue(uint32_t now) const { return mPending && now - mRequestTime >= mSaveDelayMs; }
+
+  // Write the staged settings if due. Returns true if a record was written;
+  // on a QSPI error the save is retried after another delay.
+  bool Process(uint32_t now)
+  {
+    if (!SaveDue(now) || NumSlots() == 0)
+      return false;
+
+    // A slot left dirty (e.g. by a torn write) is never programmed over:
+    // move on to the start of the next sector, which gets erased.
+    uint32_t slot = mNextSlot;
+    if (slot % SlotsPerSector() != 0 && !_Erased(slot))
+      slot = (slot / SlotsPerSector() + 1) % mNumSectors * SlotsPerSector();
+
+    const uint32_t address = kQspiBase + _Offset(slot);
+    if (slot % SlotsPerSector() == 0)
+    {
+      const daisy::QSPIHandle::Result result = mQspi.Erase(address, address + kSectorSize);
+      // The scan in Init() may have cached the old contents.
+      _InvalidateCache(slot, kSectorSize);
+      if (result != daisy::QSPIHandle::Result::OK)
+      {
+        mRequestTime = now;
+        return false;
+      }
+    }
+
+    Record record;
+    std::memset(&record, 0xff, sizeof(record));
+    record.magic = kMagic;
+    record.sequence = mSequence + 1;
+    record.settings = mSettings;
+    record.checksum = _Checksum(record);
+    const daisy::QSPIHandle::Result result = mQspi.Write(address, sizeof(record), reinterpret_cast<uint8_t*>(&record));
+    _InvalidateCache(slot, kSlotSize);
+    if (result != daisy::QSPIHandle::Result::OK)
+    {
+      mRequestTime = now;
+      return false;
+    }
+
+    mSequence = record.sequence;
+    mNextSlot = slot + 1 == NumSlots() ? 0 : slot + 1;
+    mStored = mSettings;
+    mPending = false;
+    return true;
+  }
+
+  uint32_t SlotsPerSector() const { return kSectorSize / kSlotSize; }
+  uint32_t NumSlots() const { return mNumSectors * SlotsPerSector(); }
+
+private:
+  static constexpr uint32_t kQspiBase = 0x90000000;
+  static constexpr uint32_t kMagic = 0x4d554c45;  // "MULE"
+
+  struct Record
+  {
+    uint32_t magic;
+    uint32_t sequence;
+    T settings;
+    uint32_t checksum;
+  };
+  // Records start on page-program friendly 32-byte boundaries.
+  static constexpr uint32_t kSlotSize = (sizeof(Record) + 31) & ~(uint32_t)31;
+  static_assert(kSlotSize <= kSectorSize, "Settings don't fit a QSPI sector");
+
+  uint32_t _Offset(uint32_t slot) const
+  {
+    return mRegionOffset + slot / SlotsPerSector() * kSectorSize + slot % SlotsPerSector() * kSlotSize;
+  }
+
+  const uint8_t* _Mapped(uint32_t slot) const
+  {
+    return reinterpret_cast<const uint8_t*>(mQspi.GetData(_Offset(slot)));
+  }
+
+  // Drop cached lines of the memory-mapped view after the flash changed.
+  void _InvalidateCache(uint32_t slot, uint32_t bytes) const
+  {
+    dsy_dma_invalidate_cache_for_buffer(const_cast<uint8_t*>(_Mapped(slot)), bytes);
+  }
+
+  bool _Erased(uint32_t slot) const
+  {
+    const uint8_t* bytes = _Mapped(slot);
+    for (uint32_t i = 0; i < kSlotSize; i++)
+      if (bytes[i] != 0xff)
+        return false;
+    return true;
+  }
+
+  // FNV-1a over everything before the checksum.
+  static uint32_t _Checksum(const Record& record)
+  {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(Record, checksum); i++)
+      hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+  }
+
+  daisy::QSPIHandle& mQspi;
+  const uint32_t mRegionOffset;
+  const uint32_t mNumSectors;
+  const uint32_t mSaveDelayMs;
+
+  T mSettings;
+  // What the newest record holds, so unchanged requests write nothing.
+  T mStored;
+  bool mPending = false;
+  uint32_t mRequestTime = 0;
+  uint32_t mSequence = 0;
+  uint32_t mNextSlot = 0;
+};
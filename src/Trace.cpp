@@ -0,0 +1,94 @@
+//
+//  Trace.cpp
+//
+//  Timestamped begin/end events, drained over USB CDC.
+//
+
+#include "Trace.h"
+
+#include "daisy_seed.h"
+
+
+#if TRACE
+namespace
+{
+struct FrameHeader
+{
+  char magic[4];
+  uint16_t version;
+  uint16_t count;
+  uint32_t lost;
+  uint32_t clockHz;
+};
+
+struct Frame
+{
+  FrameHeader header;
+  Trace::Record records[Trace::kFrameRecords];
+};
+
+// Two frames, so one can be refilled while USB may still be sending the
+// other.
+Frame _frames[2];
+size_t _nextFrame = 0;
+bool _pending = false;  // _frames[_nextFrame] is filled but not yet accepted
+uint32_t _read = 0;
+uint32_t _lost = 0;
+} // namespace
+
+Trace::Record Trace::sRing[Trace::kCapacity];
+std::atomic<uint32_t> Trace::sWrite{0};
+#endif
+
+
+void Trace::Drain(daisy::DaisySeed& seed)
+{
+#if TRACE
+  Frame& frame = _frames[_nextFrame];
+  if (!_pending)
+  {
+    size_t count = 0;
+    const uint32_t write = sWrite.load(std::memory_order_relaxed);
+    if (write - _read > kCapacity)
+    {
+      // Lapped: everything before the last kCapacity records is gone
+      _lost += write - kCapacity - _read;
+      _read = write - kCapacity;
+    }
+    while (_read != write && count < kFrameRecords)
+    {
+      const Record& record = sRing[_read & (kCapacity - 1)];
+      if (record.sequence != (uint16_t)_read)
+        break;  // Claimed but not yet published: next time
+      std::atomic_signal_fence(std::memory_order_acquire);
+      Record& copy = frame.records[count];
+      copy.cycles = record.cycles;
+      copy.event = record.event;
+      copy.kind = record.kind;
+      copy.sequence = (uint16_t)_read;
+      std::atomic_signal_fence(std::memory_order_acquire);
+      // Overwritten while copying: a producer lapped this slot
+      if (record.sequence == (uint16_t)_read)
+        count++;
+      else
+        _lost++;
+      _read++;
+    }
+    if (count == 0)
+      return;
+
+    frame.header = {{'M', 'T', 'R', 'C'}, 1, (uint16_t)count, _lost, (uint32_t)SystemCoreClock};
+    _pending = true;
+  }
+
+  const size_t bytes = sizeof(FrameHeader) + frame.header.count * sizeof(Record);
+  if (seed.usb_handle.TransmitInternal(reinterpret_cast<uint8_t*>(&frame), bytes)
+      == daisy::UsbHandle::Result::OK)
+  {
+    _pending = false;
+    _nextFrame ^= 1;
+  }
+#else
+  (void)seed;
+#endif
+}
@@ -0,0 +1,132 @@
+//
+//  Trace.h
+//
+//  Timestamped begin/end events from the audio callback and the main loop,
+//  for finding out what a load spike lines up with.
+//
+//  Any context (audio callback, timer interrupt, main loop) records into one
+//  lock-free ring: a record claims its slot with an atomic increment, stamps
+//  it with the DWT cycle counter and publishes it by writing its sequence
+//  number last. The main loop calls Drain() every few milliseconds to send
+//  what has been recorded over USB CDC in binary frames, alongside any
+//  PrintLine() text. If it falls behind, the oldest records are overwritten
+//  and counted as lost. tools/trace_to_chrome.py turns a capture into a
+//  Chrome trace (chrome://tracing, Perfetto) or a text summary.
+//
+//  Frame, little-endian: "MTRC", uint16 version (1), uint16 record count,
+//  uint32 records lost so far, uint32 cycle counter rate in Hz, then per
+//  record: uint32 cycles, uint8 event, uint8 kind, uint16 sequence.
+//
+//  Only built in with TRACE=1 (make TRACE=1). Otherwise every call is an
+//  empty inline, so the engines can be instrumented and still build for the
+//  host tools.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef TRACE
+#define TRACE 0
+#endif
+
+#if TRACE
+#include "stm32h7xx_hal.h"
+#endif
+
+
+namespace daisy
+{
+class DaisySeed;
+}
+
+
+class Trace
+{
+public:
+  // Keep in step with EVENTS in tools/trace_to_chrome.py.
+  enum class Event : uint8_t
+  {
+    AudioCallback,
+    BassBoost,
+    Convolution,
+    HistoryRewind,  // Linear history copied back to its start
+    IrSwap,         // A committed IR slot went live (instant)
+    ControlTask,
+    LedTask,
+    SettingsTask,
+    OverloadTask,
+    IrLoad,         // loadIrToRam()
+    IrInit,         // ImpulseResponse::Init() of a slot
+    SettingsWrite,  // Settings log erase/write
+    BoostFold,      // One slice of the bass boost fold
+    Count
+  };
+
+  enum class Kind : uint8_t
+  {
+    Begin,
+    End,
+    Instant,
+  };
+
+  struct Record
+  {
+    uint32_t cycles;
+    uint8_t event;
+    uint8_t kind;
+    // Low bits of the record's index; written last to publish the record.
+    volatile uint16_t sequence;
+  };
+
+  // Records in the ring, a power of two: ~40 ms of the busiest case
+  // (8-sample blocks, every stage traced).
+  static constexpr size_t kCapacity = 4096;
+  // Records per frame sent by Drain().
+  static constexpr size_t kFrameRecords = 256;
+
+  static void Begin(Event event) { _Record(event, Kind::Begin); }
+  static void End(Event event) { _Record(event, Kind::End); }
+  static void Mark(Event event) { _Record(event, Kind::Instant); }
+
+  // Begin now, End when it goes out of scope.
+  class Scope
+  {
+  public:
+    explicit Scope(Event event) : mEvent(event) { Begin(mEvent); }
+    ~Scope() { End(mEvent); }
+
+  private:
+    Event mEvent;
+  };
+
+  // Send up to kFrameRecords published records as one frame, unless USB is
+  // still busy with the last one. Call from the main loop only; the log must
+  // have been started with StartLog(), which brings up USB CDC.
+  static void Drain(daisy::DaisySeed& seed);
+
+private:
+  static void _Record(Event event, Kind kind)
+  {
+#if TRACE
+    const uint32_t index = sWrite.fetch_add(1, std::memory_order_relaxed);
+    Record& record = sRing[index & (kCapacity - 1)];
+    record.cycles = DWT->CYCCNT;
+    record.event = (uint8_t)event;
+    record.kind = (uint8_t)kind;
+    // One core: only the compiler could reorder the publish before the data
+    std::atomic_signal_fence(std::memory_order_release);
+    record.sequence = (uint16_t)index;
+#else
+    (void)event;
+    (void)kind;
+#endif
+  }
+
+#if TRACE
+  static Record sRing[kCapacity];
+  static std::atomic<uint32_t> sWrite;
+#endif
+};
@@ -59,8 +59,65 @@ void Hothouse::Init(bool boost) {
 void Hothouse::DelayMs(size_t del) { seed.DelayMs(del); }
 
 void Hothouse::SetHidUpdateRates() {
+  const float rate = ControlRate();
   for (size_t i = 0; i < KNOB_LAST; i++) {
-    knobs[i].SetSampleRate(AudioCallbackRate());
+    knobs[i].SetSampleRate(rate);
+  }
+}
+
+float Hothouse::ControlRate() {
+  return control_timer_running_ ? (float)CONTROL_TICK_HZ : AudioCallbackRate();
+}
+
+void Hothouse::StartControlTimer() {
+  if (control_timer_running_) {
+    return;
+  }
+
+  // TIM2 is libDaisy's system clock, so use TIM5 (also 32 bits). Its
+  // interrupt sits below the audio DMA's, so a tick never delays a block.
+  TimerHandle::Config cfg;
+  cfg.periph = TimerHandle::Config::Peripheral::TIM_5;
+  cfg.dir = TimerHandle::Config::CounterDir::UP;
+  cfg.enable_irq = true;
+  control_timer_.Init(cfg);
+  control_timer_.SetPeriod(control_timer_.GetFreq() / CONTROL_TICK_HZ - 1);
+  control_timer_.SetCallback(ControlTimerCallback, this);
+
+  control_timer_running_ = true;
+  SetHidUpdateRates();
+  control_timer_.Start();
+}
+
+void Hothouse::ControlTimerCallback(void *data) {
+  Hothouse *hothouse = static_cast<Hothouse *>(data);
+  hothouse->ProcessAllControls();
+  hothouse->control_ticks_ = hothouse->control_ticks_ + 1;
+}
+
+bool Hothouse::AddTask(TaskCallback callback, uint32_t period_ticks) {
+  if (num_tasks_ >= MAX_TASKS || callback == NULL) {
+    return false;
+  }
+  const uint32_t period = period_ticks > 0 ? period_ticks : 1;
+  tasks_[num_tasks_++] = {callback, period, control_ticks_ + period};
+  return true;
+}
+
+void Hothouse::RunTasks() {
+  ProcessFootswitchEvents();
+  for (size_t i = 0; i < num_tasks_; i++) {
+    Task &task = tasks_[i];
+    const uint32_t now = control_ticks_;
+    // Wrap-safe: due once `next` is not in the future
+    if ((int32_t)(now - task.next) < 0) {
+      continue;
+    }
+    task.callback();
+    task.next += task.period;
+    if ((int32_t)(now - task.next) >= 0) {
+      task.next = now + task.period;
+    }
   }
 }
 
@@ -115,11 +172,54 @@ float Hothouse::GetKnobValue(Knob k) {
 }
 
 void Hothouse::ProcessDigitalControls() {
+  const uint32_t now = System::GetNow();
+  bool changed[SWITCH_LAST];
   for (size_t i = 0; i < SWITCH_LAST; i++) {
-    switches[i].Debounce();
+    SwitchState &state = switch_states_[i];
+    const bool raw = switches[i].RawState();
+    changed[i] = false;
+    if (raw != state.raw) {
+      state.raw = raw;
+      state.edge_time = now;
+    } else if (raw != state.pressed && now - state.edge_time >= DEBOUNCE_MS) {
+      state.pressed = raw;
+      state.changed_time = state.edge_time;
+      changed[i] = true;
+    }
+  }
+  ProcessFootswitchPresses(FOOTSWITCH_1, changed[FOOTSWITCH_1], now);
+  ProcessFootswitchPresses(FOOTSWITCH_2, changed[FOOTSWITCH_2], now);
+}
+
+void Hothouse::ProcessFootswitchEvents() {
+  FootswitchCallbacks *callbacks = footswitchCallbacks;
+  FootswitchEvent event;
+  while (footswitch_events_.Pop(event)) {
+    if (callbacks == NULL) {
+      continue;  // Deregistered since it was queued
+    }
+    void (*handler)(Switches) = NULL;
+    switch (event.type) {
+      case FootswitchEvent::NORMAL_PRESS:
+        handler = callbacks->HandleNormalPress;
+        break;
+      case FootswitchEvent::DOUBLE_PRESS:
+        handler = callbacks->HandleDoublePress;
+        break;
+      case FootswitchEvent::LONG_PRESS:
+        handler = callbacks->HandleLongPress;
+        break;
+    }
+    if (handler != NULL) {
+      handler(event.footswitch);
+    }
   }
-  ProcessFootswitchPresses(FOOTSWITCH_1);
-  ProcessFootswitchPresses(FOOTSWITCH_2);
+}
+
+void Hothouse::QueueFootswitchEvent(FootswitchEvent::Type type,
+                                    Switches footswitch) {
+  // A full queue drops the event: the main loop has stalled for a while
+  footswitch_events_.Push({type, footswitch});
 }
 
 void Hothouse::InitSwitches() {
@@ -130,6 +230,11 @@ void Hothouse::InitSwitches() {
 
   for (size_t i = 0; i < SWITCH_LAST; i++) {
     switches[i].Init(pin_numbers[i]);
+    // Start from the pins as they are, so a switch held at power-on reads
+    // as held straight away rather than after DEBOUNCE_MS
+    const bool raw = switches[i].RawState();
+    switch_states_[i].raw = raw;
+    switch_states_[i].pressed = raw;
   }
 }
 
@@ -148,12 +253,12 @@ void Hothouse::InitAnalogControls() {
   // Initialize ADC with configuration
   seed.adc.Init(cfg, KNOB_LAST);
 
-  // Get the audio callback rate once
-  float callback_rate = AudioCallbackRate();
+  // Get the control rate once
+  float control_rate = ControlRate();
 
-  // Initialize knobs with ADC pointers and callback rate
+  // Initialize knobs with ADC pointers and control rate
   for (size_t i = 0; i < KNOB_LAST; ++i) {
-    knobs[i].Init(seed.adc.GetPtr(i), callback_rate);
+    knobs[i].Init(seed.adc.GetPtr(i), control_rate);
   }
 }
 
@@ -162,14 +267,11 @@ Hothouse::ToggleswitchPosition Hothouse::GetToggleswitchPosition(
     Toggleswitch tsw) {
   switch (tsw) {
     case (TOGGLESWITCH_1):
-      return GetLogicalSwitchPosition(switches[SWITCH_1_UP],
-                                      switches[SWITCH_1_DOWN]);
+      return GetLogicalSwitchPosition(SWITCH_1_UP, SWITCH_1_DOWN);
     case (TOGGLESWITCH_2):
-      return GetLogicalSwitchPosition(switches[SWITCH_2_UP],
-                                      switches[SWITCH_2_DOWN]);
+      return GetLogicalSwitchPosition(SWITCH_2_UP, SWITCH_2_DOWN);
     case (TOGGLESWITCH_3):
-      return GetLogicalSwitchPosition(switches[SWITCH_3_UP],
-                                      switches[SWITCH_3_DOWN]);
+      return GetLogicalSwitchPosition(SWITCH_3_UP, SWITCH_3_DOWN);
     default:
       seed.PrintLine(
           "ERROR: Unexpected value provided for Toggleswitch 'tsw'. "
@@ -179,10 +281,10 @@ Hothouse::ToggleswitchPosition Hothouse::GetToggleswitchPosition(
 }
 
 void Hothouse::CheckResetToBootloader() {
-  if (switches[Hothouse::FOOTSWITCH_1].Pressed()) {
-    if (footswitch_start_time[0] == 0) {
-      footswitch_start_time [0]= System::GetNow();
-    } else if (System::GetNow() - footswitch_start_time[0] >= HOLD_THRESHOLD_MS) {
+  if (Pressed(Hothouse::FOOTSWITCH_1)) {
+    if (reset_hold_start_ == 0) {
+      reset_hold_start_ = System::GetNow();
+    } else if (System::GetNow() - reset_hold_start_ >= HOLD_THRESHOLD_MS) {
       // Shut 'er down so the LEDs always flash
       StopAdc();
       StopAudio();
@@ -211,68 +313,63 @@ void Hothouse::CheckResetToBootloader() {
     }
   } else {
     // Reset the hold timer if the footswitch is released
-    footswitch_start_time[0] = 0;
+    reset_hold_start_ = 0;
   }
 }
 
-Hothouse::ToggleswitchPosition Hothouse::GetLogicalSwitchPosition(Switch up,
-                                                                  Switch down) {
-  return up.Pressed()
+Hothouse::ToggleswitchPosition Hothouse::GetLogicalSwitchPosition(
+    Switches up, Switches down) {
+  return Pressed(up)
              ? TOGGLESWITCH_UP
-             : (down.Pressed() ? TOGGLESWITCH_DOWN : TOGGLESWITCH_MIDDLE);
+             : (Pressed(down) ? TOGGLESWITCH_DOWN : TOGGLESWITCH_MIDDLE);
 }
 
 void Hothouse::RegisterFootswitchCallbacks(FootswitchCallbacks *callbacks) {
   footswitchCallbacks = callbacks;
 }
 
-// Watches for normal, double, and long presses of the footswitches.
-void Hothouse::ProcessFootswitchPresses(Switches footswitch) {
+// Watches for normal, double, and long presses of the footswitches, and
+// queues them for ProcessFootswitchEvents(). `changed` is set on the pass the
+// debounced state changed; press times run from the edge, not the pass.
+void Hothouse::ProcessFootswitchPresses(Switches footswitch, bool changed,
+                                        uint32_t now) {
   if (footswitchCallbacks == NULL) {
     return; // Nothing to do if callbacks have not been registered
   }
-  bool is_pressed = switches[footswitch].RisingEdge();
+  const SwitchState &state = switch_states_[footswitch];
   int footswitch_index = footswitch == Hothouse::FOOTSWITCH_1 ? 0 : 1;
 
-  uint32_t now = System::GetNow();
-
-  if (is_pressed == true && footswitch_last_state[footswitch_index] == false) {
+  if (changed && state.pressed) {
     // Footswitch is pressed
-    footswitch_start_time[footswitch_index] = now;
+    const uint32_t pressed_at = state.changed_time;
+    footswitch_start_time[footswitch_index] = pressed_at;
 
-    if ((now - footswitch_last_press_time[footswitch_index]) <= DOUBLE_PRESS_THRESHOLD_MS) {
+    if ((pressed_at - footswitch_last_press_time[footswitch_index]) <= DOUBLE_PRESS_THRESHOLD_MS) {
       footswitch_press_count[footswitch_index]++;
     } else {
       footswitch_press_count[footswitch_index] = 1;
     }
 
-    footswitch_last_press_time[footswitch_index] = now;
+    footswitch_last_press_time[footswitch_index] = pressed_at;
     footswitch_long_press_triggered[footswitch_index] = false; // Reset long press trigger when pressed
   }
 
-  uint32_t press_duration = now - footswitch_start_time[footswitch_index];
-
-  if (switches[footswitch].Pressed() && press_duration >= HOLD_THRESHOLD_MS && !footswitch_long_press_triggered[footswitch_index]) {
+  if (state.pressed && now - footswitch_start_time[footswitch_index] >= HOLD_THRESHOLD_MS && !footswitch_long_press_triggered[footswitch_index]) {
     // Footswitch is being held down
-    if (footswitchCallbacks->HandleLongPress != NULL) {
-      footswitchCallbacks->HandleLongPress(footswitch);
-    }
+    QueueFootswitchEvent(FootswitchEvent::LONG_PRESS, footswitch);
     footswitch_long_press_triggered[footswitch_index] = true; // Ensure long press is only triggered once
   }
 
-  if (is_pressed == false && footswitch_last_state[footswitch_index] == true) {
+  if (changed && !state.pressed) {
     // Button released
+    const uint32_t press_duration = state.changed_time - footswitch_start_time[footswitch_index];
     if (!footswitch_long_press_triggered[footswitch_index]) {
       if (footswitch_press_count[footswitch_index] >= 2) {
-        if (footswitchCallbacks->HandleDoublePress != NULL) {
-          footswitchCallbacks->HandleDoublePress(footswitch);
-        }
+        QueueFootswitchEvent(FootswitchEvent::DOUBLE_PRESS, footswitch);
         footswitch_press_count[footswitch_index] = 0;
-      } else if (press_duration < HOLD_THRESHOLD_MS && footswitchCallbacks->HandleNormalPress != NULL) {
-        footswitchCallbacks->HandleNormalPress(footswitch);
+      } else if (press_duration < HOLD_THRESHOLD_MS) {
+        QueueFootswitchEvent(FootswitchEvent::NORMAL_PRESS, footswitch);
       }
     }
   }
-
-  footswitch_last_state[footswitch_index] = is_pressed;
-}
\ No newline at end of file
+}
@@ -17,6 +17,8 @@
 #include "daisy_seed.h"
 #include "optional"
 
+#include "ControlQueue.h"
+
 using daisy::AdcChannelConfig;
 using daisy::AnalogControl;
 using daisy::AudioHandle;
@@ -25,6 +27,7 @@ using daisy::Led;
 using daisy::Pin;
 using daisy::SaiHandle;
 using daisy::Switch;
+using daisy::TimerHandle;
 
 namespace clevelandmusicco {
 class Hothouse {
@@ -73,6 +76,9 @@ class Hothouse {
     TOGGLESWITCH_3,
   };
 
+  /** Main loop task run by RunTasks() */
+  typedef void (*TaskCallback)();
+
   struct FootswitchCallbacks {
     /** Called when a single footswitch press is detected. */
     void (*HandleNormalPress)(Switches footswitch);
@@ -151,6 +157,32 @@ class Hothouse {
   /** Call at the same frequency as controls are read for stable readings.*/
   void ProcessAnalogControls();
 
+  /** Start the control timer: a hardware timer interrupt that processes all
+   * controls (knobs, switches) at CONTROL_TICK_HZ, independent of the audio
+   * block size and of whatever the main loop is doing. The knob filters are
+   * re-derived for the tick rate. Don't call ProcessAllControls() yourself
+   * once it's running.
+   */
+  void StartControlTimer();
+
+  /** Rate in Hz the controls are processed at: the tick rate once the
+   * control timer is running, otherwise the audio callback rate.
+   */
+  float ControlRate();
+
+  /** Run `callback` from RunTasks() every `period_ticks` control ticks.
+   * \return false when all task slots are taken.
+   */
+  bool AddTask(TaskCallback callback, uint32_t period_ticks);
+
+  /** Call from the main loop: delivers queued footswitch events, then runs
+   * every task that is due, in the order they were added and at most once
+   * per call. A task that fell behind (e.g. behind a
+   * QSPI erase) runs once and resumes its period from now instead of
+   * bursting.
+   */
+  void RunTasks();
+
   /** Process Analog and Digital Controls */
   inline void ProcessAllControls() {
     ProcessAnalogControls();
@@ -163,9 +195,22 @@ class Hothouse {
   */
   float GetKnobValue(Knob k);
 
-  /** Process digital controls */
+  /** Process digital controls: sample every switch, timestamp its edges and
+   * debounce it (see DEBOUNCE_MS), and queue footswitch press events. */
   void ProcessDigitalControls();
 
+  /** Debounced state of a switch, as of the last ProcessDigitalControls().
+   * Use this rather than switches[sw].Pressed(): the Switch objects only
+   * configure and read the pins.
+   */
+  bool Pressed(Switches sw) const { return switch_states_[sw].pressed; }
+
+  /** Hand the footswitch events queued by ProcessDigitalControls() to the
+   * registered callbacks. RunTasks() calls it; call it yourself only when
+   * not using the task scheduler.
+   */
+  void ProcessFootswitchEvents();
+
   /** Get the current position of a toggleswitch (up, down, or middle).
   \param tsw Which toggleswitch to interogate (TOGGLESWITCH_1, TOGGLESWITCH_2,
   or TOGGLESWITCH_3) \return TOGGLESWITCH_UP (0), TOGGLESWITCH_MIDDLE (1), or
@@ -184,12 +229,17 @@ class Hothouse {
 
   /** Register/Deregister footswitch press callbacks. This provides an
    * alternative way of handling foot switch presses and allows effects to make
-   * use of double and long presses.
+   * use of double and long presses. Presses are detected where the switches
+   * are processed (the control timer interrupt, once it's running) and the
+   * callbacks run from ProcessFootswitchEvents(), in the main loop.
    * \param callbacks A pointer to the struct that defines the callbacks or NULL
    * to deregister all callbacks.
    */
   void RegisterFootswitchCallbacks(FootswitchCallbacks *callbacks);
 
+  static const uint32_t CONTROL_TICK_HZ = 1000;  // Control timer rate
+  static const uint32_t DEBOUNCE_MS = 5;  // A switch edge must hold this long
+
   DaisySeed seed; /**< & */
 
   AnalogControl knobs[KNOB_LAST]; /**< & */
@@ -199,12 +249,46 @@ class Hothouse {
   void SetHidUpdateRates();
   void InitSwitches();
   void InitAnalogControls();
-  ToggleswitchPosition GetLogicalSwitchPosition(Switch up, Switch down);
-  void ProcessFootswitchPresses(Switches footswitch);
+  ToggleswitchPosition GetLogicalSwitchPosition(Switches up, Switches down);
+  void ProcessFootswitchPresses(Switches footswitch, bool changed, uint32_t now);
+  static void ControlTimerCallback(void *data);
+
+  struct Task {
+    TaskCallback callback;
+    uint32_t period;
+    uint32_t next;  // Tick the task is next due at
+  };
+  static const size_t MAX_TASKS = 8;
+  Task tasks_[MAX_TASKS];
+  size_t num_tasks_ = 0;
+
+  TimerHandle control_timer_;
+  bool control_timer_running_ = false;
+  volatile uint32_t control_ticks_ = 0;
+
+  // Timestamp debouncing: the pin is sampled every pass and each raw edge
+  // timestamped; the debounced state follows once the pin has held for
+  // DEBOUNCE_MS, dated at that last edge.
+  struct SwitchState {
+    bool raw = false;
+    bool pressed = false;
+    uint32_t edge_time = 0;  // Last raw edge, ms
+    uint32_t changed_time = 0;  // Edge the debounced state last changed at, ms
+  };
+  SwitchState switch_states_[SWITCH_LAST];
+
+  // Footswitch presses, from ProcessDigitalControls() to the main loop
+  struct FootswitchEvent {
+    enum Type { NORMAL_PRESS, DOUBLE_PRESS, LONG_PRESS };
+    Type type;
+    Switches footswitch;
+  };
+  ControlQueue<FootswitchEvent, 8> footswitch_events_;
+  void QueueFootswitchEvent(FootswitchEvent::Type type, Switches footswitch);
 
+  uint32_t reset_hold_start_ = 0;  // CheckResetToBootloader()'s hold timer
   uint32_t footswitch_start_time[2] = {0, 0};  // Store footswitch start time
   uint32_t footswitch_last_press_time[2] = {0, 0};
-  bool footswitch_last_state[2] = {false, false};
   uint8_t footswitch_press_count[2] = {0, 0};
   bool footswitch_long_press_triggered[2] = {false, false};
   static const uint32_t HOLD_THRESHOLD_MS = 2000;  // 2 second hold time
@@ -212,7 +296,7 @@ class Hothouse {
 
   inline uint16_t* adc_ptr(const uint8_t chn) { return seed.adc.GetPtr(chn); }
 
-  FootswitchCallbacks *footswitchCallbacks = NULL;
+  FootswitchCallbacks *volatile footswitchCallbacks = NULL;
 };
 
 }  // namespace clevelandmusicco
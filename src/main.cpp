@@ -1,25 +1,49 @@
 // MuleBox - Guitar Processing Unit
-// A simple passthrough audio application for the Electrosmith Daisy Seed
-// running on the Cleveland Audio Hothouse platform.
+// A cabinet simulator for the Electrosmith Daisy Seed running on the
+// Cleveland Audio Hothouse platform.
 //
-// This program passes input audio directly to output, serving as a
-// foundation for building guitar effects processing.
+// The input runs through a bass boost (KNOB_1) and then an impulse response
+// convolution, built for the direct, partitioned or hybrid engine. KNOB_2
+// picks the IR from a bank (TOGGLESWITCH_1), TOGGLESWITCH_2 trades latency
+// for CPU through the audio block size, and TOGGLESWITCH_3 plays one IR or
+// pairs it with the next as a blend (KNOB_3) or in stereo. IRs crossfade on
+// a switch and are streamed from QSPI into an SDRAM cache in the background.
+// The selection is saved to a QSPI settings log, and an overload guard
+// shortens the IRs if the callback overruns.
 
 #include "hothouse.h"
-#include "daisysp.h"
 #include "hid/parameter.h"
-#include "ImpulseResponse/ImpulseResponse.h"
+#include "BassBoost.h"
+#include "ControlQueue.h"
+#include "CpuProfiler.h"
+#include "EffectChain.h"
+#include "IRLoader.h"
+#include "OverloadGuard.h"
+#include "SettingsLog.h"
+#include "Trace.h"
+#include "ImpulseResponse/BlockFloat.h"
+#include "ImpulseResponse/IRCache.h"
+#include "ImpulseResponse/IRFolder.h"
+#include "ImpulseResponse/IRManager.h"
+#include "ImpulseResponse/IRMemory.h"
 #include "ImpulseResponse/ir_data.h"
 
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
 using clevelandmusicco::Hothouse;
 
+// Build with BOOST_FOLD=1 to fold the bass boost into the IR while idle.
+#ifndef BOOST_FOLD
+#define BOOST_FOLD 0
+#endif
+
 using daisy::Parameter;
 using daisy::Led;
-using daisy::PersistentStorage;
 using daisy::SaiHandle;
 using daisy::AudioHandle;
 
-using daisysp::Svf;
 
 // Helper class to debounce discrete selections from analog controls
 class DebouncedAnalogSwitch {
@@ -70,47 +94,553 @@ class DebouncedAnalogSwitch {
     int pendingValue_;
 };
 
+// Maps a knob to a parameter range the way daisy::Parameter does, but from
+// the knob's filtered Value(): the control timer already steps the knob
+// filters, and Parameter::Process() would step them a second time.
+class KnobParameter {
+  public:
+    void Init(AnalogControl& knob, float min, float max, Parameter::Curve curve) {
+        knob_ = &knob;
+        min_ = min;
+        max_ = max;
+        curve_ = curve;
+        logMin_ = logf(min < 0.0000001f ? 0.0000001f : min);
+        logMax_ = logf(max);
+    }
+
+    float Process() const {
+        const float value = knob_->Value();
+        switch (curve_) {
+            case Parameter::EXPONENTIAL:
+                return min_ + value * value * (max_ - min_);
+            case Parameter::LOGARITHMIC:
+                return expf(logMin_ + value * (logMax_ - logMin_));
+            case Parameter::CUBE:
+                return min_ + value * value * value * (max_ - min_);
+            default:
+                return min_ + value * (max_ - min_);
+        }
+    }
+
+  private:
+    AnalogControl* knob_ = nullptr;
+    float min_ = 0.0f;
+    float max_ = 1.0f;
+    float logMin_ = 0.0f;
+    float logMax_ = 0.0f;
+    Parameter::Curve curve_ = Parameter::LINEAR;
+};
+
 /**
  * Hardware interface
  */
 
 Hothouse hw;
 DebouncedAnalogSwitch irSwitch;
+DebouncedAnalogSwitch blockModeSwitch;
+DebouncedAnalogSwitch irModeSwitch;
 Led ledLeft, ledRight;
-Parameter boostGainParam;
-Parameter irSelectorParam;  // For resistor ladder IR selection
+KnobParameter boostGainParam;
+KnobParameter irSelectorParam;  // For resistor ladder IR selection
+KnobParameter irBlendParam;     // Dual IR blend, KNOB_3
 
 
 /**
  * Fixed constants
  */
-constexpr int SETTINGS_VERSION = 4;  // Bumped for IR bypass flag removal
+constexpr int SETTINGS_VERSION = 5;  // Bumped for the settings log
+// Settings log: the top 64 KB of the 8 MB QSPI chip, clear of the IR data
+// linked into .qspiflash_data from the bottom.
+constexpr uint32_t SETTINGS_LOG_OFFSET = 0x7F0000;
+constexpr uint32_t SETTINGS_LOG_SIZE = 0x10000;
+constexpr uint32_t SETTINGS_SAVE_DELAY_MS = 3000;  // Save once the controls settle
 constexpr float SAMPLE_RATE = 48000.0f;  // Audio sample rate in Hz
-static const float BASS_BOOST_FREQ = 110.0f;  // Center frequency in Hz
-static const float BASS_BOOST_Q = 0.7f;       // Q factor (bandwidth)
 constexpr int MAX_IR_POSITIONS = 12;          // Rotary positions supported by hardware
+constexpr int IR_BANK_COUNT = 3;              // Banks of MAX_IR_POSITIONS, on TOGGLESWITCH_1
+constexpr float IR_CROSSFADE_MS = 20.0f;      // Crossfade time when switching IRs
+constexpr uint32_t CPU_REPORT_MS = 1000;      // CPU_PROFILE builds: serial report interval
+constexpr uint32_t CONTROL_TASK_MS = 1;       // IR selection, knobs to the audio callback
+constexpr uint32_t LED_TASK_MS = 10;          // LED refresh
+constexpr uint32_t SETTINGS_TASK_MS = 100;    // Pending settings save
+constexpr uint32_t OVERLOAD_TASK_MS = 100;    // Overload guard interval
+constexpr uint32_t TRACE_TASK_MS = 5;         // TRACE builds: send a trace frame
+constexpr float PARAM_RAMP_MS = 5.0f;         // Knob changes ramp over a few control passes
+
+// Bass boost folding: once the boost knob has rested for BOOST_FOLD_SETTLE_MS
+// (within BOOST_FOLD_TOLERANCE of wet gain), its EQ is convolved into a copy
+// of the IR, a few hundred thousand MACs per control pass, and that copy
+// replaces the filter until the knob moves again.
+constexpr uint32_t BOOST_FOLD_SETTLE_MS = 500;
+constexpr float BOOST_FOLD_TOLERANCE = 0.02f;
+constexpr size_t BOOST_FOLD_MAX_TAPS = 4096;     // Boost response cut-off (85 ms)
+constexpr size_t BOOST_FOLD_MACS_PER_PASS = 200000;
+
+// The boost stage leaves the effect chain once its knob has rested below
+// BOOST_OFF_GAIN (-60 dB of wet band) for longer than the gain ramp.
+constexpr float BOOST_OFF_GAIN = 0.001f;
+constexpr uint32_t BOOST_BYPASS_MS = 50;
+
+// Latency/CPU modes on TOGGLESWITCH_2, as audio block sizes. Larger blocks
+// mean fewer callbacks and larger FFT partitions, so less CPU per sample,
+// at the cost of latency.
+constexpr size_t BLOCK_SIZE_MODES[] = {
+    8,   // UP: Low latency (0.17 ms per block)
+    32,  // MIDDLE: Balanced (0.67 ms)
+    64,  // DOWN: Efficient (1.33 ms)
+};
+
+// IR modes on TOGGLESWITCH_3. The dual modes pair the selected IR with the
+// next one and convolve both on one shared input FFT.
+enum class IrMode {
+    Mono,    // UP: One IR on both outputs
+    Blend,   // MIDDLE: Selected and next IR, mixed by KNOB_3
+    Stereo,  // DOWN: Selected IR left, next IR right
+};
+
+// Scheduler periods are in control timer ticks.
+constexpr uint32_t msToTicks(uint32_t ms) {
+    return ms * Hothouse::CONTROL_TICK_HZ / 1000;
+}
 
 /**
  * DSP Globals
  */
-Svf bassBoost;
-ImpulseResponse ir;
+BassBoost bassBoost;
+IRManager irManager;  // Double-buffered IR slots, crossfades on switch
+IRLoader irLoader;    // MDMA copies of IR data out of QSPI
+IRCache irCache;      // Every IR in engine-native form, filled in the background
+CpuProfiler cpuProfiler;  // Audio callback load, CPU_PROFILE builds only
+OverloadGuard overloadGuard;  // Shortens the IRs while the callback overruns
+
+// Boot timeline: when each startup phase finished, in microseconds since
+// hw.Init() started the system timer. CPU_PROFILE builds print it once the
+// IR cache is full.
+struct BootPhase {
+    const char* name;
+    uint32_t us;
+};
+constexpr size_t MAX_BOOT_PHASES = 8;
+BootPhase bootPhases[MAX_BOOT_PHASES];
+size_t bootPhaseCount = 0;
+bool bootComplete = false;  // The last phase, the IR cache fill, is done
+bool bootReported = false;
+uint32_t reportedIrClips = 0;  // Last fixed-point clip count printed
+
+// Record the end of phase `name`, the first time only.
+void bootMark(const char* name) {
+    for (size_t i = 0; i < bootPhaseCount; i++) {
+        if (bootPhases[i].name == name) {
+            return;
+        }
+    }
+    if (bootPhaseCount < MAX_BOOT_PHASES) {
+        bootPhases[bootPhaseCount++] = {name, daisy::System::GetUs()};
+    }
+}
+
+// Knob values and effect chain routes from the main loop to the audio
+// callback. The main loop reads and maps the controls; the callback only
+// drains the queue and ramps.
+struct ControlMessage {
+    enum class Type {
+        BoostGain,
+        IrBlend,
+        EffectRoute,  // `route`: the effect chain stages to run
+    };
+    Type type;
+    union {
+        float value;
+        uint32_t route;
+    };
+};
+ControlQueue<ControlMessage, 16> controlQueue;
+ParameterRamp boostGainRamp;  // Audio side
+ParameterRamp irBlendRamp;    // Audio side
 int currentIrIndex = 0;  // Currently loaded IR
-volatile bool irBypass = false;  // When true, skip IR convolution
+bool irBypass = false;  // Main loop view: a bypass position is in effect
+IrMode irMode = IrMode::Mono;        // Requested on TOGGLESWITCH_3
+IrMode loadedIrMode = IrMode::Mono;  // Requested when the current IR was loaded
+size_t loadedIrTier = 0;             // Overload guard tier the current IR was loaded at
+
+// Bass boost folding state (main loop). irFolded: the live slot has the
+// boost folded in, at irFoldedGain. foldIrIndex: IR being folded, or -1.
+bool irFolded = false;
+float irFoldedGain = 0.0f;
+int foldIrIndex = -1;
+float foldGain = 0.0f;
+IRFolder irFolder;
+
+// The mono stages ahead of the IR manager. The chain's scratch buffer, which
+// carries the block between its stages and into the IR manager, holds one
+// audio block and is touched every sample, so the chain lives in
+// zero-wait-state DTCM.
+constexpr size_t MAX_AUDIO_BLOCK_SIZE = 256;
+constexpr size_t MAX_EFFECT_STAGES = 4;
+DTCM_MEM_SECTION static EffectChain<MAX_EFFECT_STAGES, MAX_AUDIO_BLOCK_SIZE> effectChain;
+
+// Bass boost stage: the callback sets the block's ramped wet gain before
+// running the chain.
+struct BoostStage {
+    float gainStart;
+    float gainEnd;
+};
+BoostStage boostStageGain = {0.0f, 0.0f};
+uint32_t boostStage = 0;  // Its bit in an effect chain route
+
+void processBoostStage(void* context, const float* inputs, float* outputs, size_t numFrames) {
+    const BoostStage* stage = static_cast<const BoostStage*>(context);
+    bassBoost.ProcessBlock(inputs, outputs, numFrames, stage->gainStart, stage->gainEnd);
+}
+
+void resetBoostStage(void*) {
+    bassBoost.Reset();
+}
 
-// RAM buffer for active IR (copied from QSPI flash)
-// Max size is 8,192 samples as defined in ImpulseResponse
+// RAM buffers for IR data streamed from QSPI flash by the MDMA loader:
+// float taps go to irRamBuffer, Q15/Q31 taps and partition spectra to
+// irStagingBuffer. Max size is 8,192 samples as defined in ImpulseResponse.
+// Only read while an IR slot is initialised, so they go in SDRAM to keep
+// the fast memories for the convolution state. Cache-line aligned for the
+// DMA.
 constexpr size_t MAX_IR_BUFFER_SIZE = 8192;
-static float irRamBuffer[MAX_IR_BUFFER_SIZE];
+constexpr size_t IR_STAGING_BYTES = 128 * 1024;
+DSY_SDRAM_BSS __attribute__((aligned(32))) static float irRamBuffer[MAX_IR_BUFFER_SIZE];
+// The active IR with the bass boost folded in, and the boost's response.
+DSY_SDRAM_BSS static float irFoldBuffer[MAX_IR_BUFFER_SIZE];
+DSY_SDRAM_BSS static float boostResponse[BOOST_FOLD_MAX_TAPS];
+DSY_SDRAM_BSS __attribute__((aligned(32))) static uint8_t irStagingBuffer[IR_STAGING_BYTES];
+
+// Backing memory for irCache. The largest native form is partition spectra
+// at ~73 KB per full-length IR (8-sample blocks), so 36 IRs take ~2.6 MB.
+constexpr size_t IR_CACHE_BYTES = 4 * 1024 * 1024;
+DSY_SDRAM_BSS __attribute__((aligned(32))) static uint8_t irCacheMemory[IR_CACHE_BYTES];
+
+// Memory pools for the IR engines' buffers, one per region. Which buffers
+// go where is the IR_PLACE_* build-time map (see IRMemory.h); anything that
+// doesn't fit falls back to the heap. DTCM also holds the stack, so the
+// pool leaves it 32 KB. `make memreport` lists the resulting layout.
+constexpr size_t IR_POOL_DTCM_SIZE = 96 * 1024;
+constexpr size_t IR_POOL_AXI_SIZE = 320 * 1024;
+constexpr size_t IR_POOL_SDRAM_SIZE = 4 * 1024 * 1024;
+DTCM_MEM_SECTION static uint8_t irPoolDtcm[IR_POOL_DTCM_SIZE];
+static uint8_t irPoolAxi[IR_POOL_AXI_SIZE];
+DSY_SDRAM_BSS static uint8_t irPoolSdram[IR_POOL_SDRAM_SIZE];
+
+// Crossfade the audio path to dry. Returns false while a previous switch is
+// still fading; the caller retries on a later pass of the main loop.
+bool setIrBypass() {
+    if (!irManager.CommitBypass()) {
+        return false;
+    }
+    irBypass = true;
+    irFolded = false;
+    return true;
+}
+
+// Which copy of an IR this build initialises from.
+enum class IrSource {
+    None,          // Nothing this build can run: the position plays dry
+    Spectra,       // Offline-transformed partitions (partitioned engine)
+    Q15,           // Offline-quantised taps (fixed-point builds)
+    Q31,
+    Float,
+    Packed,        // Block floating point, decoded into RAM
+    FloatFromQ15,  // Header was generated without float data
+    FloatFromQ31,
+    MultiRate,     // Full-rate head plus reduced-rate tail, read straight from QSPI
+};
 
-// Load IR from QSPI flash to RAM buffer
-void loadIrToRam(int irIndex) {
+IrSource irSourceFor(const ImpulseResponseData::IRInfo& irInfo) {
     using namespace ImpulseResponseData;
 
+    // A multi-rate split only runs on its own engine, whatever the build's
+    if (irInfo.tail && irInfo.data) {
+        return IrSource::MultiRate;
+    }
+    // Partitioned builds use the offline-transformed spectra when they match
+    // the partition size, so switching is a copy with no FFTs. Fixed-point
+    // builds use the offline-quantised copy when the header has one.
+    if (ImpulseResponse::kDefaultEngine == ImpulseResponse::Engine::Partitioned
+        && irInfo.format == IRFormat::PartitionedSpectra && irInfo.partitionSize == hw.AudioBlockSize()) {
+        return IrSource::Spectra;
+    }
+    if (ImpulseResponse::kDefaultPrecision == ImpulseResponse::Precision::Q15 && irInfo.q15) {
+        return IrSource::Q15;
+    }
+    if (ImpulseResponse::kDefaultPrecision == ImpulseResponse::Precision::Q31 && irInfo.q31) {
+        return IrSource::Q31;
+    }
+    if (irInfo.data) {
+        return IrSource::Float;
+    }
+    if (irInfo.codec != IRCodec::None && irInfo.packed) {
+        return IrSource::Packed;
+    }
+    if (irInfo.q15) {
+        return IrSource::FloatFromQ15;
+    }
+    if (irInfo.q31) {
+        return IrSource::FloatFromQ31;
+    }
+    // Spectra-only header built for another partition size or engine
+    return IrSource::None;
+}
+
+int irPackedMantissaBits(const ImpulseResponseData::IRInfo& irInfo) {
+    return irInfo.codec == ImpulseResponseData::IRCodec::BlockFloat8 ? 8 : 16;
+}
+
+// The form ImpulseResponse::Init() takes a source in, which is also what the
+// IR cache holds: the float-based sources all expand to float taps.
+IrSource irNativeFor(IrSource source) {
+    switch (source) {
+        case IrSource::Packed:
+        case IrSource::FloatFromQ15:
+        case IrSource::FloatFromQ31:
+            return IrSource::Float;
+        default:
+            return source;
+    }
+}
+
+// Bytes of the first `length` taps of `source`, in whole words. The QSPI
+// arrays are 4-byte aligned, so rounding up stays inside the last word.
+size_t irSourceBytes(IrSource source, const ImpulseResponseData::IRInfo& irInfo, size_t length) {
+    size_t bytes = 0;
+    switch (source) {
+        case IrSource::Spectra: {
+            const size_t partitionSize = hw.AudioBlockSize();
+            const size_t partitions = (length + partitionSize - 1) / partitionSize;
+            bytes = partitions * (partitionSize + 1) * 2 * sizeof(float);
+            break;
+        }
+        case IrSource::Q15:
+        case IrSource::FloatFromQ15:
+            bytes = length * sizeof(int16_t);
+            break;
+        case IrSource::Q31:
+        case IrSource::FloatFromQ31:
+            bytes = length * sizeof(int32_t);
+            break;
+        case IrSource::Float:
+            bytes = length * sizeof(float);
+            break;
+        case IrSource::Packed:
+            bytes = BlockFloat::PackedBytes(length, irPackedMantissaBits(irInfo));
+            break;
+        case IrSource::MultiRate:  // Not streamed or cached: two arrays
+        case IrSource::None:
+            break;
+    }
+    return (bytes + 3) & ~(size_t)3;
+}
+
+// Where `source` lives in QSPI.
+const void* irSourceFlash(IrSource source, const ImpulseResponseData::IRInfo& irInfo) {
+    switch (source) {
+        case IrSource::Spectra: return irInfo.spectra;
+        case IrSource::Q15:
+        case IrSource::FloatFromQ15: return irInfo.q15;
+        case IrSource::Q31:
+        case IrSource::FloatFromQ31: return irInfo.q31;
+        case IrSource::Float: return irInfo.data;
+        case IrSource::Packed: return irInfo.packed;
+        default: return nullptr;
+    }
+}
+
+// Initialise an IR slot from data in its native form and hand it to the
+// audio side, which crossfades to it. The IR processor keeps its own copy of
+// the weights or spectra.
+void initIrSlot(ImpulseResponse* ir, IrSource native, const ImpulseResponseData::IRInfo& irInfo,
+                const void* data, size_t length) {
+    Trace::Scope trace(Trace::Event::IrInit);
+    // Under overload the engines get a prefix of the IR: the first taps,
+    // or the first partitions' spectra. The multi-rate tail is cheap already.
+    if (native != IrSource::MultiRate) {
+        length = overloadGuard.MaxLength(length);
+    }
+    switch (native) {
+        case IrSource::Spectra:
+            ir->Init(static_cast<const std::complex<float>*>(data), length, hw.AudioBlockSize());
+            break;
+        case IrSource::Q15:
+            ir->Init(static_cast<const int16_t*>(data), length, irInfo.qShift);
+            break;
+        case IrSource::Q31:
+            ir->Init(static_cast<const int32_t*>(data), length, irInfo.qShift);
+            break;
+        case IrSource::Float:
+            // The partitioned engine uses one audio block per IR partition.
+            ir->Init(static_cast<const float*>(data), length, ImpulseResponse::kDefaultEngine, hw.AudioBlockSize());
+            break;
+        case IrSource::MultiRate:
+            ir->Init(irInfo.data, length, irInfo.tail, irInfo.tailLength, irInfo.tailRate, irInfo.tailSplit);
+            break;
+        default:
+            break;
+    }
+    irManager.CommitLoad(native == IrSource::None);
+}
+
+void saveSettings();
+bool settingsSaveDue();
+
+// A selected IR is live (or crossfading in), loaded for `mode`.
+void irLoaded(int irIndex, IrMode mode) {
+    irFolded = false;  // Every load is the plain IR, at the current tier:
+    foldIrIndex = -1;  // a fold in progress is of the old one
+    currentIrIndex = irIndex;
+    loadedIrMode = mode;
+    loadedIrTier = overloadGuard.Tier();
+    irBypass = false;
+    bootMark("first IR");  // Fading in from the boot passthrough
+    saveSettings();  // Persist the new selection
+}
+
+// IR transfer in progress: pendingIrIndex is -1 when idle. A transfer either
+// loads an IR into the claimed slot, or (pendingIrSlot == nullptr) only
+// prefetches it into the cache.
+int pendingIrIndex = -1;
+IrSource pendingIrSource = IrSource::None;
+ImpulseResponse* pendingIrSlot = nullptr;
+IrMode pendingIrMode = IrMode::Mono;   // Mode the slot's load was requested for
+size_t pendingIrLength = 0;
+const void* pendingIrFlash = nullptr;  // Where the data lives in QSPI
+const void* pendingIrData = nullptr;   // Where the data is read from once it lands
+void* pendingIrNative = nullptr;       // Where the native form goes
+bool pendingIrCached = false;          // pendingIrNative is a reserved cache entry
+
+// Bring a finished transfer into the native form, cache it, and initialise
+// the claimed slot if there is one.
+void finishIrLoad() {
+    using namespace ImpulseResponseData;
+
+    const IRInfo& irInfo = ir_collection[pendingIrIndex];
+    const size_t length = pendingIrLength;
+    const IrSource native = irNativeFor(pendingIrSource);
+
+    if (pendingIrSource == IrSource::Packed) {
+        BlockFloat::Decode(static_cast<const uint8_t*>(pendingIrData), length,
+                           irPackedMantissaBits(irInfo), static_cast<float*>(pendingIrNative));
+    } else if (pendingIrSource == IrSource::FloatFromQ15) {
+        const int16_t* q15 = static_cast<const int16_t*>(pendingIrData);
+        float* taps = static_cast<float*>(pendingIrNative);
+        const float scale = ldexpf(1.0f, -(15 + irInfo.qShift));
+        for (size_t i = 0; i < length; i++) {
+            taps[i] = q15[i] * scale;
+        }
+    } else if (pendingIrSource == IrSource::FloatFromQ31) {
+        const int32_t* q31 = static_cast<const int32_t*>(pendingIrData);
+        float* taps = static_cast<float*>(pendingIrNative);
+        const float scale = ldexpf(1.0f, -(31 + irInfo.qShift));
+        for (size_t i = 0; i < length; i++) {
+            taps[i] = q31[i] * scale;
+        }
+    } else if (pendingIrSource != IrSource::None && pendingIrData != pendingIrNative) {
+        // Loader unavailable: read straight from QSPI. Copy when caching (and
+        // for float data, as before); the other formats init in place.
+        if (pendingIrCached || native == IrSource::Float) {
+            // Note: memcpy would be faster but this is safer for QSPI access
+            const uint32_t* from = static_cast<const uint32_t*>(pendingIrData);
+            uint32_t* to = static_cast<uint32_t*>(pendingIrNative);
+            const size_t words = irSourceBytes(native, irInfo, length) / sizeof(uint32_t);
+            for (size_t i = 0; i < words; i++) {
+                to[i] = from[i];
+            }
+        } else {
+            pendingIrNative = const_cast<void*>(pendingIrData);
+        }
+    }
+
+    if (pendingIrCached) {
+        irCache.Commit(pendingIrIndex);
+    }
+    const int irIndex = pendingIrIndex;
+    pendingIrIndex = -1;
+
+    if (pendingIrSlot) {
+        initIrSlot(pendingIrSlot, native, irInfo, pendingIrNative, length);
+        irLoaded(irIndex, pendingIrMode);
+    }
+}
+
+// Start streaming IR `irIndex` out of QSPI with the MDMA, into its cache
+// entry when there is room. `slot` is the claimed IR slot to initialise
+// once it lands, or nullptr to only fill the cache.
+void startIrTransfer(int irIndex, ImpulseResponse* slot) {
+    using namespace ImpulseResponseData;
+
+    const IRInfo& irInfo = ir_collection[irIndex];
+    const size_t length = std::min(irInfo.length, MAX_IR_BUFFER_SIZE);
+    const IrSource source = irSourceFor(irInfo);
+    const IrSource native = irNativeFor(source);
+
+    void* cacheEntry = nullptr;
+    if (source != IrSource::None) {
+        cacheEntry = irCache.Reserve(irIndex, irSourceBytes(native, irInfo, length));
+    }
+    if (!slot && !cacheEntry) {
+        return;  // Nothing to prefetch into
+    }
+
+    pendingIrIndex = irIndex;
+    pendingIrSource = source;
+    pendingIrSlot = slot;
+    pendingIrLength = length;
+    pendingIrFlash = irSourceFlash(source, irInfo);
+    pendingIrCached = cacheEntry != nullptr;
+    if (cacheEntry) {
+        pendingIrNative = cacheEntry;
+    } else if (native == IrSource::Float) {
+        pendingIrNative = irRamBuffer;
+    } else {
+        pendingIrNative = irStagingBuffer;
+    }
+
+    // Straight into the native buffer when there's nothing to convert
+    void* destination = source == native ? pendingIrNative : irStagingBuffer;
+    size_t capacity = sizeof(irStagingBuffer);
+    if (destination == cacheEntry) {
+        capacity = irSourceBytes(native, irInfo, length);
+    } else if (destination == irRamBuffer) {
+        capacity = sizeof(irRamBuffer);
+    }
+
+    const size_t bytes = irSourceBytes(source, irInfo, length);
+    if (bytes > 0 && bytes <= capacity && irLoader.Start(pendingIrFlash, destination, bytes)) {
+        pendingIrData = destination;
+        return;
+    }
+
+    // Nothing to stream, or the loader can't take it: read QSPI directly
+    pendingIrData = pendingIrFlash;
+    finishIrLoad();
+}
+
+// Load an IR into the inactive IR slot. A cached IR is initialised right
+// away from SDRAM, without touching QSPI; otherwise its data is streamed in
+// by the MDMA while the main loop keeps running, and the main loop calls
+// finishIrLoad() once it lands. The audio callback keeps playing the
+// current IR until then. Returns false while a previous load or switch is
+// still in progress.
+bool loadIrToRam(int irIndex) {
+    using namespace ImpulseResponseData;
+    Trace::Scope trace(Trace::Event::IrLoad);
+
     // If no IRs are compiled in, nothing to load.
     if (IR_COUNT == 0) {
-        irBypass = true;
-        return;
+        return setIrBypass();
+    }
+
+    if (pendingIrIndex >= 0) {
+        return false;
+    }
+
+    // Claim the inactive slot for the whole load
+    ImpulseResponse* ir = irManager.BeginLoad();
+    if (!ir) {
+        return false;
     }
 
     // Validate index
@@ -118,18 +648,113 @@ void loadIrToRam(int irIndex) {
         irIndex = 0;
     }
 
-    const IRInfo& irInfo = ir_collection[irIndex];
+    // The dual modes pair this IR with the next one on a shared FFT. Their
+    // spectra are built straight from the float taps in QSPI, so both IRs
+    // need them; otherwise the pair plays mono.
+    if (irMode != IrMode::Mono) {
+        const IRInfo& irA = ir_collection[irIndex];
+        const IRInfo& irB = ir_collection[(irIndex + 1) % IR_COUNT];
+        if (IR_COUNT > 1 && irA.data && irB.data) {
+            const ImpulseResponse::DualMode mode = irMode == IrMode::Stereo
+                                                       ? ImpulseResponse::DualMode::Stereo
+                                                       : ImpulseResponse::DualMode::Blend;
+            Trace::Scope traceInit(Trace::Event::IrInit);
+            ir->Init(irA.data, overloadGuard.MaxLength(std::min(irA.length, MAX_IR_BUFFER_SIZE)),
+                     irB.data, overloadGuard.MaxLength(std::min(irB.length, MAX_IR_BUFFER_SIZE)), mode,
+                     hw.AudioBlockSize());
+            irManager.CommitLoad();
+            irLoaded(irIndex, irMode);
+            return true;
+        }
+    }
 
-    // Copy from QSPI to RAM
-    // Note: memcpy would be faster but this is safer for QSPI access
-    for (size_t i = 0; i < irInfo.length; i++) {
-        irRamBuffer[i] = irInfo.data[i];
+    if (const void* cached = irCache.Find(irIndex)) {
+        const IRInfo& irInfo = ir_collection[irIndex];
+        initIrSlot(ir, irNativeFor(irSourceFor(irInfo)), irInfo, cached,
+                   std::min(irInfo.length, MAX_IR_BUFFER_SIZE));
+        irLoaded(irIndex, irMode);
+        return true;
     }
 
-    // Initialize IR processor with RAM buffer
-    ir.Init(irRamBuffer, irInfo.length);
-    currentIrIndex = irIndex;
-    irBypass = false;
+    pendingIrMode = irMode;
+    startIrTransfer(irIndex, ir);
+    return true;
+}
+
+// Fill the IR cache in the background, one IR at a time whenever the loader
+// is idle, so every later switch is served from SDRAM.
+size_t irPrefetchNext = 0;
+
+void prefetchIrs() {
+    using namespace ImpulseResponseData;
+
+    // A due settings save gets the next gap between transfers
+    if (pendingIrIndex >= 0 || irLoader.Busy() || settingsSaveDue()) {
+        return;
+    }
+    while (irPrefetchNext < IR_COUNT && pendingIrIndex < 0) {
+        const size_t irIndex = irPrefetchNext++;
+        if (!irCache.Contains(irIndex)) {
+            startIrTransfer((int)irIndex, nullptr);
+        }
+    }
+    if (!bootComplete && irPrefetchNext >= IR_COUNT && pendingIrIndex < 0) {
+        bootMark("IR cache");
+        bootComplete = true;
+    }
+}
+
+// Block size for a TOGGLESWITCH_2 position.
+size_t blockSizeForMode(int position) {
+    if (position < 0 || position >= (int)(sizeof(BLOCK_SIZE_MODES) / sizeof(BLOCK_SIZE_MODES[0]))) {
+        position = 0;
+    }
+    return BLOCK_SIZE_MODES[position];
+}
+
+// IR switch crossfade at the current block size.
+size_t crossfadeBlocks() {
+    const size_t blocks = (size_t)(IR_CROSSFADE_MS * 0.001f * hw.AudioSampleRate()) / hw.AudioBlockSize();
+    return std::max<size_t>(blocks, 1);
+}
+
+void AudioCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size);
+
+// Restart audio at a new block size. The IR engines' partitions follow the
+// block size, so the current IR is rebuilt and crossfaded in. Cached IRs
+// that have partition spectra are cached as spectra at one block size and as
+// taps at the others, so those entries are dropped and refilled; the rest
+// don't depend on the block size and stay. Returns false while an IR load
+// or switch is in progress; the caller retries later.
+bool setAudioBlockSize(size_t blockSize) {
+    if (pendingIrIndex >= 0 || irManager.Busy()) {
+        return false;
+    }
+
+    hw.StopAudio();
+    hw.SetAudioBlockSize(blockSize);  // Also re-derives the knob filter rates
+    irManager.SetFadeBlocks(crossfadeBlocks());
+    cpuProfiler.Init(hw.AudioBlockSize(), hw.AudioSampleRate());
+    overloadGuard.Init(cpuProfiler.Deadline(), daisy::System::GetNow());
+    if (ImpulseResponse::kDefaultEngine == ImpulseResponse::Engine::Partitioned) {
+        for (size_t i = 0; i < ImpulseResponseData::IR_COUNT; i++) {
+            if (ImpulseResponseData::ir_collection[i].format == ImpulseResponseData::IRFormat::PartitionedSpectra) {
+                irCache.Invalidate(i);
+            }
+        }
+    }
+    irPrefetchNext = 0;
+    hw.StartAudio(AudioCallback);
+
+    // Until the rebuilt IR fades in, the old one keeps playing: every
+    // engine accepts any block size. The partitioned and Dual engines move
+    // to a partition of latency on blocks smaller than their partition, so
+    // the new input runs that much late until the crossfade, while what is
+    // already ringing plays on without a gap.
+    if (!irBypass) {
+        loadIrToRam(currentIrIndex);
+    }
+    return true;
 }
 
 /**
@@ -138,7 +763,7 @@ void loadIrToRam(int irIndex) {
 
 struct Settings {
     int version;
-    int irIndex;   // Last selected IR index (0-11)
+    int irIndex;   // Last selected IR index (bank * 12 + position)
 
     bool operator!=(const Settings& a) const {
         return !(
@@ -148,27 +773,23 @@ struct Settings {
     }
 };
 
-PersistentStorage<Settings> savedSettings(hw.seed.qspi);
-bool triggerSettingsSave = false;
-
-void loadSettings() {
+SettingsLog<Settings> savedSettings(hw.seed.qspi, SETTINGS_LOG_OFFSET, SETTINGS_LOG_SIZE, SETTINGS_SAVE_DELAY_MS);
 
-    // Reference to local copy of settings stored in flash
-    Settings &localSettings = savedSettings.GetSettings();
+void loadSettings(const Settings& defaultSettings) {
 
-    int savedVersion = localSettings.version;
+    // Newest record in the settings log, if any
+    savedSettings.Init(defaultSettings);
+    Settings localSettings = savedSettings.Get();
 
-    if (savedVersion != SETTINGS_VERSION) {
+    if (localSettings.version != SETTINGS_VERSION) {
         // Something has changed. Load defaults!
-        savedSettings.RestoreDefaults();
-        loadSettings();
-        return;
+        localSettings = defaultSettings;
     }
 
     // Load IR index and copy from QSPI to RAM
     int irIndex = localSettings.irIndex;
 
-    // If no IRs exist in this build, force bypass.
+    // If no IRs exist in this build, stay bypassed (IR slots start dry).
     if (ImpulseResponseData::IR_COUNT == 0) {
         irBypass = true;
         return;
@@ -179,19 +800,23 @@ void loadSettings() {
         irIndex = 0;
     }
 
-    // Load IR from QSPI flash to RAM and initialize processor
-    // This will also un-bypass
+    // Start streaming the IR from QSPI flash to RAM; the main loop
+    // initializes the processor (and un-bypasses) once it lands
     loadIrToRam(irIndex);
 }
 
+// Stage the current settings. They're written once nothing has changed for
+// SETTINGS_SAVE_DELAY_MS, so stepping through IRs costs one write.
 void saveSettings() {
-    //Reference to local copy of settings stored in flash
-    Settings &localSettings = savedSettings.GetSettings();
-
+    Settings localSettings;
     localSettings.version = SETTINGS_VERSION;
     localSettings.irIndex = currentIrIndex;
 
-    triggerSettingsSave = true;
+    savedSettings.Request(localSettings, daisy::System::GetNow());
+}
+
+bool settingsSaveDue() {
+    return savedSettings.SaveDue(daisy::System::GetNow());
 }
 
 
@@ -199,52 +824,411 @@ void saveSettings() {
 
 
 
+// Float taps of an IR to fold the boost into: the cached copy when it's
+// float, else the QSPI original. nullptr when there are none (Q15/Q31 or
+// spectra-only headers) or the IR runs the multi-rate engine.
+const float* foldSourceFor(int irIndex, size_t& length) {
+    const ImpulseResponseData::IRInfo& irInfo = ImpulseResponseData::ir_collection[irIndex];
+    if (irInfo.tail) {
+        return nullptr;
+    }
+    length = overloadGuard.MaxLength(std::min(irInfo.length, MAX_IR_BUFFER_SIZE));
+    const void* cached = irCache.Find(irIndex);
+    if (cached && irNativeFor(irSourceFor(irInfo)) == IrSource::Float) {
+        return static_cast<const float*>(cached);
+    }
+    return irInfo.data;
+}
+
+// Fold the bass boost into the IR while its knob rests, and hand it back
+// to the filter when the knob moves.
+float boostSettleGain = -1.0f;
+uint32_t boostSettleTime = 0;
+
+void updateBoostFold(float gain) {
+    const uint32_t now = daisy::System::GetNow();
+    if (std::fabs(gain - boostSettleGain) > BOOST_FOLD_TOLERANCE) {
+        boostSettleGain = gain;
+        boostSettleTime = now;
+        foldIrIndex = -1;  // Any fold in progress is for the old gain
+    }
+
+    // Knob moved: reload the plain IR, which runs behind the filter again.
+    // Retried next pass while a load is in progress.
+    if (irFolded) {
+        if (std::fabs(gain - irFoldedGain) > BOOST_FOLD_TOLERANCE) {
+            loadIrToRam(currentIrIndex);
+        }
+        return;
+    }
+
+    // Only the mono path folds; anything that changes the live IR cancels
+    if (irBypass || irMode != IrMode::Mono || loadedIrMode != IrMode::Mono) {
+        foldIrIndex = -1;
+        return;
+    }
+
+    if (foldIrIndex < 0) {
+        if (now - boostSettleTime < BOOST_FOLD_SETTLE_MS || pendingIrIndex >= 0 || irManager.Busy()) {
+            return;
+        }
+        size_t length = 0;
+        const float* taps = foldSourceFor(currentIrIndex, length);
+        if (!taps) {
+            return;
+        }
+        foldGain = boostSettleGain;
+        const size_t boostTaps = bassBoost.Response(foldGain, boostResponse, BOOST_FOLD_MAX_TAPS);
+        irFolder.Init(taps, length, boostResponse, boostTaps, irFoldBuffer, MAX_IR_BUFFER_SIZE);
+        foldIrIndex = currentIrIndex;
+    }
+
+    if (foldIrIndex != currentIrIndex || pendingIrIndex >= 0) {
+        foldIrIndex = -1;
+        return;
+    }
+    Trace::Begin(Trace::Event::BoostFold);
+    const bool folded = irFolder.Step(BOOST_FOLD_MACS_PER_PASS);
+    Trace::End(Trace::Event::BoostFold);
+    if (!folded) {
+        return;
+    }
+
+    // Folded: swap it in like any IR switch (retried while busy)
+    ImpulseResponse* ir = irManager.BeginLoad();
+    if (!ir) {
+        return;
+    }
+    ir->Init(irFoldBuffer, irFolder.Length(), ImpulseResponse::kDefaultEngine, hw.AudioBlockSize());
+    irManager.CommitLoad(false, true);
+    irFolded = true;
+    irFoldedGain = foldGain;
+    foldIrIndex = -1;
+}
+
+// Queue a knob value for the audio callback if it changed since the last
+// one sent. A full queue just leaves it for the next pass.
+float sentBoostGain = -1.0f;
+float sentIrBlend = -1.0f;
+
+void pushControl(ControlMessage::Type type, float value, float& sent) {
+    if (value == sent) {
+        return;
+    }
+    if (controlQueue.Push({type, value})) {
+        sent = value;
+    }
+}
+
+// Route the effect chain: every stage, less the boost once its knob has
+// rested at off. Returns false while the audio side may still be running
+// an older route, so the caller can hold back controls that depend on it.
+uint32_t sentEffectRoute = 0;
+uint32_t boostOffSince = 0;
+bool boostOff = false;
+
+bool updateEffectRoute(float boostGain) {
+    const uint32_t now = daisy::System::GetNow();
+    uint32_t route = effectChain.AllStages();
+    if (boostGain < BOOST_OFF_GAIN) {
+        if (!boostOff) {
+            boostOff = true;
+            boostOffSince = now;
+        }
+        if (now - boostOffSince >= BOOST_BYPASS_MS) {
+            route &= ~boostStage;
+        }
+    } else {
+        boostOff = false;
+    }
+
+    if (route != sentEffectRoute) {
+        ControlMessage message;
+        message.type = ControlMessage::Type::EffectRoute;
+        message.route = route;
+        if (!controlQueue.Push(message)) {
+            return false;
+        }
+        sentEffectRoute = route;
+    }
+    return true;
+}
+
 // Audio callback - processes audio samples
 // This is called at the audio rate (typically 48kHz / block size)
+// Processing runs as a block pipeline: the effect chain runs its routed
+// stages (the bass boost) over the block, then the IR manager consumes the
+// whole block in one call. IR switches
+// (including bypass) are prepared by the main loop and only swapped and
+// crossfaded here.
 void AudioCallback(AudioHandle::InputBuffer in,
                    AudioHandle::OutputBuffer out,
                    size_t size) {
+    Trace::Scope trace(Trace::Event::AudioCallback);
+    const uint32_t callbackStart = CpuProfiler::Now();
+
+    // Apply every control change queued since the last block
+    ControlMessage message;
+    while (controlQueue.Pop(message)) {
+        switch (message.type) {
+            case ControlMessage::Type::BoostGain:
+                boostGainRamp.SetTarget(message.value);
+                break;
+            case ControlMessage::Type::IrBlend:
+                irBlendRamp.SetTarget(message.value);
+                break;
+            case ControlMessage::Type::EffectRoute:
+                effectChain.SetRoute(message.route);
+                break;
+        }
+    }
 
-    
+    // Mono input from the left channel only; the boost gain ramps per sample.
+    // While every live IR has the boost folded in, the filter is skipped and
+    // restarts clean (the chain resets it) when a plain IR fades back in.
+    const bool boostNeeded = irManager.BeginBlock(size);
+    boostStageGain.gainStart = boostGainRamp.Value();
+    boostStageGain.gainEnd = boostGainRamp.Advance(size);
+    const float* chained = effectChain.Process(in[0], size, boostNeeded ? 0 : boostStage);
+
+    const uint32_t boostEnd = CpuProfiler::Now();
+
+    // Mono IRs write the same signal to both outputs, stereo dual IRs one
+    // IR per channel
+    irManager.SetBlend(irBlendRamp.Advance(size));
+    Trace::Begin(Trace::Event::Convolution);
+    irManager.ProcessBlock(in[0], chained, out[0], out[1], size);
+    Trace::End(Trace::Event::Convolution);
+    const uint32_t irEnd = CpuProfiler::Now();
+
+    const uint32_t callbackCycles = CpuProfiler::Now() - callbackStart;
+    cpuProfiler.Record(CpuProfiler::Stage::BassBoost, boostEnd - callbackStart);
+    cpuProfiler.Record(CpuProfiler::Stage::Convolution, irEnd - boostEnd);
+    cpuProfiler.Record(CpuProfiler::Stage::Callback, callbackCycles);
+    overloadGuard.Record(callbackCycles, irManager.Idle(), irManager.Switching());
+}
 
-    // Process boost gain parameter (maps knob to 0-3.0x range)
-    float wetGain = boostGainParam.Process();
+/**
+ * Main loop tasks, run by the Hothouse scheduler. The control timer
+ * processes the knobs and switches on every tick in its interrupt; these
+ * only act on the results.
+ */
 
-    for (size_t i = 0; i < size; i++) {
-        // Read mono input from left channel only
-        float monoInput = in[0][i];
+#if CPU_PROFILE
+// Print the callback load; with CPU_PROFILE_LEDS, the right LED shows
+// whether a deadline was missed in the last interval
+void cpuReportTask() {
+    // The boot timeline, once the background phases are done
+    if (!bootReported && bootComplete) {
+        uint32_t previous = 0;
+        for (size_t i = 0; i < bootPhaseCount; i++) {
+            hw.seed.PrintLine("boot: %-12s at %7lu us (+%lu us)", bootPhases[i].name,
+                              (unsigned long)bootPhases[i].us, (unsigned long)(bootPhases[i].us - previous));
+            previous = bootPhases[i].us;
+        }
+        hw.seed.PrintLine("IR cache: %lu of %lu KB", (unsigned long)(irCache.Used() / 1024),
+                          (unsigned long)(irCache.Capacity() / 1024));
+        bootReported = true;
+    }
+    const bool overloaded = cpuProfiler.Report(hw.seed);
+    // Q15/Q31 builds: IRs with too little headroom for the input
+    const uint32_t irClips = irManager.ClipCount();
+    if (irClips != reportedIrClips) {
+        hw.seed.PrintLine("IR clips: %lu since load", (unsigned long)irClips);
+        reportedIrClips = irClips;
+    }
+#if CPU_PROFILE_LEDS
+    ledRight.Set(overloaded ? 1.0f : 0.0f);
+#else
+    (void)overloaded;
+#endif
+}
+#endif
+
+// IR loads, knobs to the audio callback, IR and mode selection
+void controlTask() {
+    Trace::Scope trace(Trace::Event::ControlTask);
+    // Finish an IR load once the MDMA has streamed it into RAM
+    if (pendingIrIndex >= 0 && irLoader.Poll()) {
+        if (irLoader.Failed()) {
+            pendingIrData = pendingIrFlash;
+        }
+        finishIrLoad();
+    }
+    prefetchIrs();
+
+    // Boost gain (0 to BassBoost::kMaxGain) and dual IR blend
+    // The boost stage is routed back in before its gain rises.
+    const float boostGain = boostGainParam.Process();
+    if (updateEffectRoute(boostGain)) {
+        pushControl(ControlMessage::Type::BoostGain, boostGain, sentBoostGain);
+    }
+    pushControl(ControlMessage::Type::IrBlend, irBlendParam.Process(), sentIrBlend);
+
+    // Check IR selection from resistor ladder (KNOB_2)
+    // Resistor ladder provides 12 discrete voltage levels
+    // We debounce the integer position to ensure we only load the IR when the knob stops moving.
+    float rawValue = irSelectorParam.Process();
+    int rawPosition = (int)(rawValue + 0.5f);  // Round to nearest integer
+
+    // Clamp to selector's physical range (0..11)
+    if (rawPosition < 0) rawPosition = 0;
+    if (rawPosition >= MAX_IR_POSITIONS) rawPosition = MAX_IR_POSITIONS - 1;
+
+    // Process through debouncer to get stable position
+    int selectedPosition = irSwitch.Process(rawPosition);
+
+    // TOGGLESWITCH_1 picks the bank (UP, MIDDLE, DOWN), the rotary the
+    // IR within it.
+    int bank = (int)hw.GetToggleswitchPosition(Hothouse::TOGGLESWITCH_1);
+    if (bank < 0 || bank >= IR_BANK_COUNT) bank = 0;
+    selectedPosition += bank * MAX_IR_POSITIONS;
+
+    // TOGGLESWITCH_2 picks the latency mode. A change waits for any IR
+    // load to finish.
+    const size_t blockSize = blockSizeForMode(
+        blockModeSwitch.Process((int)hw.GetToggleswitchPosition(Hothouse::TOGGLESWITCH_2)));
+    if (blockSize != hw.AudioBlockSize()) {
+        setAudioBlockSize(blockSize);
+    }
 
-        // Process through SVF bass boost filter
-        bassBoost.Process(monoInput);
-        float peakOutput = bassBoost.Peak();
+    // TOGGLESWITCH_3 picks mono or one of the dual IR modes
+    int irModePosition = irModeSwitch.Process((int)hw.GetToggleswitchPosition(Hothouse::TOGGLESWITCH_3));
+    if (irModePosition < 0 || irModePosition > (int)IrMode::Stereo) irModePosition = 0;
+    irMode = (IrMode)irModePosition;
 
-        // Blend dry signal with boosted peak output
-        float boosted = monoInput + (peakOutput * wetGain);
+    // Bypass if selector position exceeds compiled IR count.
+    bool shouldBypass = (selectedPosition >= (int)ImpulseResponseData::IR_COUNT);
 
-        // If selector points beyond available IRs, bypass convolution.
-        float output = boosted;
-        if (!irBypass) {
-            output = ir.Process(boosted);
+    // Apply selection changes. Both calls refuse while a previous load
+    // or crossfade is in progress, so the change is simply retried next
+    // pass. A load persists the selection once it completes.
+    if (shouldBypass) {
+        if (!irBypass && setIrBypass()) {
+            saveSettings();
         }
+    } else if (irBypass || selectedPosition != currentIrIndex || irMode != loadedIrMode
+               || overloadGuard.Tier() != loadedIrTier) {
+        // Leaving bypass reloads the IR so its history starts clean. A new
+        // overload tier crossfades to the IR at its new length.
+        loadIrToRam(selectedPosition);
+    }
+
+#if BOOST_FOLD
+    // Fold the boost into the IR once its knob rests
+    updateBoostFold(boostGain);
+#endif
+
+    // Check if footswitch 1 is held for reset to bootloader mode
+    hw.CheckResetToBootloader();
+}
 
-        // Output to both stereo channels (dual mono)
-        out[0][i] = output;  // Left channel
-        out[1][i] = output;  // Right channel
+// Step the IR length down while the callback overruns and back up once it
+// has headroom; controlTask() reloads the IR at the new tier. LED 2 lights
+// while the IRs are shortened (unless it shows CPU_PROFILE overruns).
+void overloadTask() {
+    Trace::Scope trace(Trace::Event::OverloadTask);
+    if (!overloadGuard.Update(daisy::System::GetNow())) {
+        return;
     }
+#if CPU_PROFILE
+    hw.seed.PrintLine("overload: tier %u of %u, IRs up to %u taps, load %lu.%lu%%",
+                      (unsigned)overloadGuard.Tier(), (unsigned)(OverloadGuard::kNumTiers - 1),
+                      (unsigned)overloadGuard.MaxLength(MAX_IR_BUFFER_SIZE),
+                      (unsigned long)(overloadGuard.LoadPermille() / 10),
+                      (unsigned long)(overloadGuard.LoadPermille() % 10));
+#endif
+#if !CPU_PROFILE_LEDS
+    ledRight.Set(overloadGuard.Tier() > 0 ? 1.0f : 0.0f);
+#endif
+}
+
+void ledTask() {
+    Trace::Scope trace(Trace::Event::LedTask);
+    ledLeft.Update();
+    ledRight.Update();
 }
 
+// Write staged settings once due. Writing takes QSPI out of memory-mapped
+// mode, so wait for any IR transfer out of it to finish; prefetching holds
+// off meanwhile. The control timer keeps reading the controls while a
+// sector erase blocks this loop.
+void settingsTask() {
+    Trace::Scope trace(Trace::Event::SettingsTask);
+    if (!irLoader.Busy() && pendingIrIndex < 0 && settingsSaveDue()) {
+        Trace::Scope traceWrite(Trace::Event::SettingsWrite);
+        savedSettings.Process(daisy::System::GetNow());
+    }
+}
+
+#if TRACE
+// Send what the trace has recorded since the last pass
+void traceTask() {
+    Trace::Drain(hw.seed);
+}
+#endif
+
 int main(void) {
+    // Staged boot: only what the audio callback needs comes before audio
+    // starts. The IR slots start out dry, so the pedal passes the boosted
+    // signal straight away; the saved IR is loaded and crossfaded in from
+    // the main loop, and the IR cache fills behind it.
+
     // Initialize the Hothouse hardware
     hw.Init(true); // max CPU speed
-    hw.SetAudioBlockSize(8);  // Process 8 samples at a time
     hw.SetAudioSampleRate(SaiHandle::Config::SampleRate::SAI_48KHZ);
+    bootMark("hardware");
+
+    // Controls are read on the control timer from here on. Block size from
+    // the latency mode toggle: the switches need a few ticks of debouncing
+    // before they read back.
+    hw.StartControlTimer();
+    hw.DelayMs(16);
+    hw.SetAudioBlockSize(blockSizeForMode((int)hw.GetToggleswitchPosition(Hothouse::TOGGLESWITCH_2)));
+    // Likewise the IR mode, so the first load already uses it
+    const int bootIrMode = (int)hw.GetToggleswitchPosition(Hothouse::TOGGLESWITCH_3);
+    if (bootIrMode >= 0 && bootIrMode <= (int)IrMode::Stereo) irMode = (IrMode)bootIrMode;
+    cpuProfiler.Init(hw.AudioBlockSize(), hw.AudioSampleRate());
+    overloadGuard.Init(cpuProfiler.Deadline(), daisy::System::GetNow());
+    bootMark("controls");
+
+    // Initialize bass boost EQ
+    bassBoost.Init(hw.AudioSampleRate());  // Initialize with actual sample rate
+
+    // The effect chain, in processing order. Every stage starts out routed.
+    boostStage = effectChain.AddStage(processBoostStage, &boostStageGain, resetBoostStage,
+                                      Trace::Event::BassBoost);
+    sentEffectRoute = effectChain.Route();
+
+    // Knob ramps start at zero; the first control pass ramps them in
+    const size_t rampFrames = (size_t)(PARAM_RAMP_MS * 0.001f * hw.AudioSampleRate());
+    boostGainRamp.Init(0.0f, rampFrames);
+    irBlendRamp.Init(0.0f, rampFrames);
+
+    // Memory pools must be registered before any IR buffer is allocated,
+    // and the IR slots must exist before audio starts or the first IR is
+    // loaded
+    IRMemory::AddRegion(IRMemory::Region::Dtcm, irPoolDtcm, sizeof(irPoolDtcm));
+    IRMemory::AddRegion(IRMemory::Region::Axi, irPoolAxi, sizeof(irPoolAxi));
+    IRMemory::AddRegion(IRMemory::Region::Sdram, irPoolSdram, sizeof(irPoolSdram));
+    irManager.Init(MAX_AUDIO_BLOCK_SIZE, crossfadeBlocks());
+    irManager.SetSilenceThreshold(ImpulseResponse::kDefaultSilenceThreshold);
+
+    // Start audio processing with our callback, dry until an IR is loaded
+    hw.StartAdc();
+    hw.StartAudio(AudioCallback);
+    bootMark("audio");
+
+#if CPU_PROFILE || TRACE
+    hw.seed.StartLog(false);  // USB serial, don't wait for a host
+#endif
 
     ledLeft.Init(hw.seed.GetPin(Hothouse::LED_1), false);
     ledRight.Init(hw.seed.GetPin(Hothouse::LED_2), false);
 
     boostGainParam.Init(hw.knobs[Hothouse::KNOB_1],
                         0.0f,      // Min: no boost
-                        3.0f,      // Max: ~12dB boost (10^(12/20) ≈ 3.98)
+                        BassBoost::kMaxGain,  // Max: ~12dB boost (10^(12/20) ≈ 3.98)
                         Parameter::LOGARITHMIC);
 
     // Initialize IR selector (resistor ladder on KNOB_2)
@@ -258,75 +1242,44 @@ int main(void) {
                          (float)(MAX_IR_POSITIONS - 1),    // Max value (12 positions: 0-11)
                          Parameter::LINEAR);
 
+    irBlendParam.Init(hw.knobs[Hothouse::KNOB_3],
+                      0.0f,  // All selected IR
+                      1.0f,  // All next IR
+                      Parameter::LINEAR);
+
     // Initialize debounce for IR switch (100ms)
     irSwitch.Init(100);
+    blockModeSwitch.Init(100);
+    irModeSwitch.Init(100);
 
-    // Initialize bass boost EQ
-    bassBoost.Init(hw.AudioSampleRate());  // Initialize with actual sample rate
-    bassBoost.SetFreq(BASS_BOOST_FREQ);    // Center frequency
-    bassBoost.SetRes(BASS_BOOST_Q);        // Q factor for musical width
-    
+    irLoader.Init();
+    irCache.Init(irCacheMemory, sizeof(irCacheMemory));
 
     // Update settings
     Settings defaultSettings = {
         SETTINGS_VERSION, // version
         0                 // irIndex (default to first IR)
     };
-    savedSettings.Init(defaultSettings);
-    loadSettings();  // Load saved settings and initialize IR
-
-    // Start audio processing with our callback
-    hw.StartAdc();
-    hw.StartAudio(AudioCallback);
-
-    // Main loop - runs continuously
+    loadSettings(defaultSettings);  // Load saved settings and start loading the IR
+    bootMark("settings");
+
+    // Main loop - runs the tasks as they fall due
+    hw.AddTask(controlTask, msToTicks(CONTROL_TASK_MS));
+    hw.AddTask(ledTask, msToTicks(LED_TASK_MS));
+    hw.AddTask(settingsTask, msToTicks(SETTINGS_TASK_MS));
+#if OVERLOAD_GUARD
+    hw.AddTask(overloadTask, msToTicks(OVERLOAD_TASK_MS));
+#endif
+#if CPU_PROFILE
+    hw.AddTask(cpuReportTask, msToTicks(CPU_REPORT_MS));
+#endif
+#if TRACE
+    hw.AddTask(traceTask, msToTicks(TRACE_TASK_MS));
+#endif
     while(1) {
-
-        // Save settings if triggered
-        if(triggerSettingsSave) {
-            savedSettings.Save();
-            triggerSettingsSave = false;
-        }
-
-        // Update LEDs
-        ledLeft.Update();
-        ledRight.Update();
-
-        // Process all hardware controls (knobs, switches)
-        hw.ProcessAllControls();
-
-        // Check IR selection from resistor ladder (KNOB_2)
-        // Resistor ladder provides 12 discrete voltage levels
-        // We debounce the integer position to ensure we only load the IR when the knob stops moving.
-        float rawValue = irSelectorParam.Process();
-        int rawPosition = (int)(rawValue + 0.5f);  // Round to nearest integer
-
-        // Clamp to selector's physical range (0..11)
-        if (rawPosition < 0) rawPosition = 0;
-        if (rawPosition >= MAX_IR_POSITIONS) rawPosition = MAX_IR_POSITIONS - 1;
-
-        // Process through debouncer to get stable position
-        int selectedPosition = irSwitch.Process(rawPosition);
-
-        // Bypass if selector position exceeds compiled IR count.
-        bool shouldBypass = (selectedPosition >= (int)ImpulseResponseData::IR_COUNT);
-
-        // Apply selection changes
-        if (shouldBypass != irBypass) {
-            irBypass = shouldBypass;
-            saveSettings();
-        }
-
-        // If not bypassed and IR selection changed, load new IR from QSPI to RAM
-        if (!shouldBypass && selectedPosition != currentIrIndex) {
-            loadIrToRam(selectedPosition);
-            saveSettings();  // Persist the new selection
-        }
-
-        // Check if footswitch 1 is held for reset to bootloader mode
-        hw.CheckResetToBootloader();
-
-        // Small delay to prevent busy-waiting
-        hw.DelayMs(10);
+        hw.RunTasks();
+        // Sleep until the next interrupt: the control timer ticks every
+        // millisecond, so no task waits longer than it would have anyway
+        __WFI();
     }
 }
@@ -0,0 +1,187 @@
+//
+//  ir_bench.cpp
+//
+//  Host benchmark for the IR convolution engines. Builds against the same
+//  sources as the firmware (make bench) and times ImpulseResponse over a
+//  grid of engines, IR lengths and block sizes.
+//
+//  For each configuration it prints throughput (Msamples/s), mean ns per
+//  sample, the worst single block in microseconds, and the realtime factor:
+//  how many 48 kHz mono streams one host core could run. Absolute numbers
+//  don't carry over to the Daisy, but ratios between engines, and
+//  regressions between commits, do. The header names the direct-form FIR
+//  kernel it was built with (IR_KERNEL). StaticImpulseResponse follows at
+//  two of its compile-time sizes.
+//
+//  Usage: ir_bench [seconds of audio per configuration, default 1]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ImpulseResponse/FirKernel.h"
+#include "ImpulseResponse/ImpulseResponse.h"
+#include "ImpulseResponse/StaticImpulseResponse.h"
+#include "ir_engines.h"
+
+
+using namespace IREngines;
+
+namespace
+{
+constexpr float kSampleRate = 48000.0f;
+const size_t kIrLengths[] = {512, 1024, 2048, 4096, 8192};
+const size_t kBlockSizes[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+// Smallest partition for the partitioned engine; smaller blocks simply
+// collect into one partition (with a partition of latency).
+constexpr size_t kMinPartitionSize = 8;
+
+// Multi-rate split point and head/tail overlap, as wav_to_ir_header.py.
+constexpr size_t kMultiRateSplit = 960;
+constexpr size_t kMultiRateFade = 64;
+
+struct Result
+{
+  double samplesPerSecond;
+  double nsPerSample;
+  double worstBlockUs;
+};
+
+// Time `process(input, output)` over numSamples in blocks of `blockSize`,
+// after warming up over twice `historyLength` samples.
+template <typename Process>
+Result _Time(Process process, size_t blockSize, size_t historyLength, size_t numSamples)
+{
+  typedef std::chrono::steady_clock Clock;
+
+  std::vector<float> input(blockSize);
+  std::vector<float> output(blockSize);
+  for (size_t i = 0; i < blockSize; i++)
+    input[i] = 0.25f * ((float)std::rand() / (float)RAND_MAX - 0.5f);
+
+  const size_t numBlocks = std::max<size_t>(1, numSamples / blockSize);
+  // Warm up caches and branch predictors: one pass over the whole history.
+  for (size_t b = 0; b < std::max<size_t>(1, 2 * historyLength / blockSize); b++)
+    process(input.data(), output.data());
+
+  Clock::duration worst = Clock::duration::zero();
+  const Clock::time_point start = Clock::now();
+  for (size_t b = 0; b < numBlocks; b++)
+  {
+    const Clock::time_point blockStart = Clock::now();
+    process(input.data(), output.data());
+    worst = std::max(worst, Clock::now() - blockStart);
+    // Keep the result live
+    input[b % blockSize] += output[0] * 1e-9f;
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  const double samples = (double)(numBlocks * blockSize);
+  Result result;
+  result.samplesPerSecond = samples / seconds;
+  result.nsPerSample = seconds * 1e9 / samples;
+  result.worstBlockUs = std::chrono::duration<double, std::micro>(worst).count();
+  return result;
+}
+
+Result _Run(const Config& config, const std::vector<float>& ir, size_t blockSize, size_t numSamples)
+{
+  ImpulseResponse impulseResponse;
+  impulseResponse.SetPrecision(config.precision);
+  impulseResponse.SetHistoryMode(config.history);
+  if (config.engine == ImpulseResponse::Engine::MultiRate && ir.size() > kMultiRateSplit + kMultiRateFade)
+  {
+    // Same cost as a real split: the head, plus every rate-th tail tap
+    std::vector<float> tail;
+    for (size_t i = kMultiRateSplit; i < ir.size(); i += config.rate)
+      tail.push_back(ir[i]);
+    impulseResponse.Init(ir.data(), kMultiRateSplit + kMultiRateFade, tail.data(), tail.size(), config.rate,
+                         kMultiRateSplit);
+  }
+  else if (config.engine == ImpulseResponse::Engine::Dual)
+  {
+    // Two IRs of the same length cost the same as two different ones
+    impulseResponse.Init(ir.data(), ir.size(), ir.data(), ir.size(),
+                         config.outputs == 2 ? ImpulseResponse::DualMode::Stereo : ImpulseResponse::DualMode::Blend,
+                         std::max(blockSize, kMinPartitionSize));
+  }
+  else
+  {
+    impulseResponse.Init(ir.data(), ir.size(), config.engine, std::max(blockSize, kMinPartitionSize));
+  }
+
+  std::vector<float> right(blockSize);
+  return _Time(
+    [&](const float* input, float* output) {
+      impulseResponse.ProcessBlock(input, output, right.data(), blockSize);
+    },
+    blockSize, ir.size(), numSamples);
+}
+
+// StaticImpulseResponse<MaxTaps, BlockSize> on an IR of MaxTaps taps.
+template <size_t MaxTaps, size_t BlockSize>
+Result _RunStatic(const std::vector<float>& ir, size_t numSamples)
+{
+  // Its arrays are far too big for the stack at the larger sizes
+  static StaticImpulseResponse<MaxTaps, BlockSize> impulseResponse;
+  impulseResponse.Init(ir.data(), ir.size());
+  return _Time([&](const float* input, float* output) { impulseResponse.ProcessBlock(input, output); }, BlockSize,
+               ir.size(), numSamples);
+}
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+  const double audioSeconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+  const size_t numSamples = (size_t)std::max(1.0, audioSeconds * kSampleRate);
+
+  std::printf("FIR kernel: %s\n", FirKernel::Name());
+  std::printf("%-13s %6s %6s %12s %10s %12s %10s\n", "engine", "taps", "block", "Msamples/s", "ns/sample",
+              "worst us", "x realtime");
+  for (const Config& config : kConfigs)
+  {
+    // The idle gate costs nothing on a steady input
+    if (config.gate)
+      continue;
+    for (size_t irLength : kIrLengths)
+    {
+      std::srand(1);
+      const std::vector<float> ir = MakeIR(irLength);
+      for (size_t blockSize : kBlockSizes)
+      {
+        const Result result = _Run(config, ir, blockSize, numSamples);
+        std::printf("%-13s %6zu %6zu %12.2f %10.2f %12.2f %10.1f\n", config.name, irLength, blockSize,
+                    result.samplesPerSecond * 1e-6, result.nsPerSample, result.worstBlockUs,
+                    result.samplesPerSecond / kSampleRate);
+        std::fflush(stdout);
+      }
+    }
+  }
+
+  // StaticImpulseResponse, on a full-length IR at each size
+  struct StaticCase
+  {
+    size_t taps;
+    size_t blockSize;
+    Result (*run)(const std::vector<float>& ir, size_t numSamples);
+  };
+  const StaticCase staticCases[] = {
+    {1024, 8, _RunStatic<1024, 8>},
+    {8192, 32, _RunStatic<8192, 32>},
+  };
+  for (const StaticCase& staticCase : staticCases)
+  {
+    std::srand(1);
+    const std::vector<float> ir = MakeIR(staticCase.taps);
+    const Result result = staticCase.run(ir, numSamples);
+    std::printf("%-13s %6zu %6zu %12.2f %10.2f %12.2f %10.1f\n", "static", staticCase.taps, staticCase.blockSize,
+                result.samplesPerSecond * 1e-6, result.nsPerSample, result.worstBlockUs,
+                result.samplesPerSecond / kSampleRate);
+    std::fflush(stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,421 @@
+//
+//  ir_check.cpp
+//
+//  Host accuracy check for the IR convolution engines. Builds against the
+//  same sources as the firmware (make check, also run by make bench) and
+//  compares ImpulseResponse against a direct convolution in double
+//  precision over a grid of engines and block sizes, including blocks
+//  that aren't a multiple of the partition size.
+//
+//  The multi-rate engine gets its IR split the way wav_to_ir_header.py
+//  --multirate does it, and is compared against the IR it stands for: the
+//  head plus the lowpassed tail. Its input is lowpassed to 0.3 / rate,
+//  below the transition band of its decimation and interpolation filters,
+//  which would otherwise dominate the error.
+//
+//  Each output is compared at the latency the engine documents for that
+//  block size. The error is the worst sample difference relative to the
+//  reference's peak; any configuration above its tolerance fails the run.
+//  Configurations with the idle gate on must also have gone idle in the
+//  input's quiet gaps, and may differ by the gate's bound (threshold times
+//  sum |h|) on top.
+//
+//  A second pass changes the block size mid-stream, as the latency switch
+//  does. A partition-based engine built for 64-sample blocks goes to 32
+//  and then 8: the input before the change must come out at no latency and
+//  the rest one partition late, with nothing lost at the change.
+//
+//  Last, StaticImpulseResponse is checked at two of its compile-time sizes
+//  against the same reference, at no latency.
+//
+//  Usage: ir_check
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ImpulseResponse/ImpulseResponse.h"
+#include "ImpulseResponse/StaticImpulseResponse.h"
+#include "ir_engines.h"
+
+
+using namespace IREngines;
+
+namespace
+{
+constexpr size_t kIrLength = 1000;
+constexpr size_t kNumSamples = 12000;
+const size_t kBlockSizes[] = {1, 3, 8, 32, 48, 64, 100, 256};
+const size_t kPartitionSizes[] = {8, 64};
+
+constexpr float kDualBlend = 0.3f;
+
+// Mid-stream block size changes: (block size, until sample), as going from
+// the Efficient latency mode to Balanced, then Low latency, mid-burst
+struct BlockChange
+{
+  size_t blockSize;
+  size_t end;
+};
+constexpr size_t kChangePartitionSize = 64;
+const BlockChange kBlockChanges[] = {{64, 1024}, {32, 6144}, {8, kNumSamples}};
+
+// StaticImpulseResponse tolerance, as the float direct-form engine
+constexpr double kStaticTolerance = 1e-4;
+
+// Multi-rate split, as wav_to_ir_header.py: MULTIRATE_FADE, and the
+// offline tail lowpass of 64 * rate + 1 taps at 0.45 / rate
+constexpr size_t kMultiRateSplit = 256;
+constexpr size_t kMultiRateFade = 64;
+constexpr double kMultiRateInputCutoff = 0.3;
+
+
+// Noise bursts with quiet gaps, below the idle gate's default threshold,
+// so engines see onsets as well as a steady signal.
+std::vector<float> _MakeInput(size_t length)
+{
+  std::vector<float> input(length);
+  for (size_t i = 0; i < length; i++)
+  {
+    const bool burst = (i / 2500) % 2 == 0;
+    const float level = burst ? 0.5f : ImpulseResponse::kDefaultSilenceThreshold;
+    input[i] = level * ((float)std::rand() / (float)RAND_MAX - 0.5f);
+  }
+  return input;
+}
+
+double _SumAbs(const std::vector<float>& ir)
+{
+  double sum = 0.0;
+  for (float tap : ir)
+    sum += std::fabs(tap);
+  return sum;
+}
+
+double _Peak(const std::vector<double>& signal)
+{
+  double peak = 0.0;
+  for (double value : signal)
+    peak = std::max(peak, std::fabs(value));
+  return peak;
+}
+
+// Blackman-windowed sinc lowpass at `cutoff` cycles/sample, unity DC gain
+// (wav_to_ir_header.py lowpass_taps()).
+std::vector<double> _Lowpass(size_t numTaps, double cutoff)
+{
+  const double pi = 3.14159265358979323846;
+  const double center = (double)(numTaps - 1) / 2.0;
+  std::vector<double> taps(numTaps);
+  double total = 0.0;
+  for (size_t k = 0; k < numTaps; k++)
+  {
+    const double t = (double)k - center;
+    const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t);
+    const double phase = 2.0 * pi * (double)k / (double)(numTaps - 1);
+    taps[k] = sinc * (0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase));
+    total += taps[k];
+  }
+  for (double& tap : taps)
+    tap /= total;
+  return taps;
+}
+
+// `input` through a causal lowpass at `cutoff` cycles/sample.
+std::vector<float> _Lowpassed(const std::vector<float>& input, double cutoff)
+{
+  const std::vector<double> taps = _Lowpass(201, cutoff);
+  std::vector<float> output(input.size());
+  for (size_t n = 0; n < input.size(); n++)
+  {
+    double acc = 0.0;
+    for (size_t k = 0; k < taps.size() && k <= n; k++)
+      acc += taps[k] * input[n - k];
+    output[n] = (float)acc;
+  }
+  return output;
+}
+
+// Split `ir` for the multi-rate engine as wav_to_ir_header.py
+// split_multirate() does. `equivalent` is the full-rate IR the split stands
+// for: the faded head plus the lowpassed, faded tail.
+void _SplitMultiRate(const std::vector<float>& ir, size_t rate, std::vector<float>& head, std::vector<float>& tail,
+                     std::vector<float>& equivalent)
+{
+  const double pi = 3.14159265358979323846;
+  head.assign(ir.begin(), ir.begin() + kMultiRateSplit + kMultiRateFade);
+  std::vector<double> fadedTail(ir.begin() + kMultiRateSplit, ir.end());
+  for (size_t i = 0; i < kMultiRateFade; i++)
+  {
+    // Raised-cosine pair summing to 1 over the overlap
+    const double gain = 0.5 * (1.0 + std::cos(pi * ((double)i + 0.5) / (double)kMultiRateFade));
+    head[kMultiRateSplit + i] = (float)(head[kMultiRateSplit + i] * gain);
+    fadedTail[i] *= 1.0 - gain;
+  }
+
+  // Zero-phase lowpass of the tail; the engine keeps every rate-th sample
+  const std::vector<double> taps = _Lowpass(64 * rate + 1, 0.45 / (double)rate);
+  const size_t center = taps.size() / 2;
+  equivalent.assign(ir.size(), 0.0f);
+  std::copy(head.begin(), head.end(), equivalent.begin());
+  tail.clear();
+  for (size_t n = 0; n < fadedTail.size(); n++)
+  {
+    double acc = 0.0;
+    for (size_t k = 0; k < taps.size(); k++)
+      if (n + center >= k && n + center - k < fadedTail.size())
+        acc += taps[k] * fadedTail[n + center - k];
+    equivalent[kMultiRateSplit + n] += (float)acc;
+    if (n % rate == 0)
+      tail.push_back((float)(rate * acc));
+  }
+}
+
+std::vector<double> _Reference(const std::vector<float>& ir, const std::vector<float>& input)
+{
+  std::vector<double> output(input.size(), 0.0);
+  for (size_t n = 0; n < input.size(); n++)
+    for (size_t k = 0; k < ir.size() && k <= n; k++)
+      output[n] += (double)ir[k] * (double)input[n - k];
+  return output;
+}
+
+// Worst |output[n] - reference[n - latency]| over the first `length`
+// samples, relative to the reference peak.
+double _Error(const std::vector<float>& output, const std::vector<double>& reference, size_t latency, size_t length)
+{
+  const double peak = _Peak(reference);
+  double error = 0.0;
+  for (size_t n = 0; n < length; n++)
+  {
+    const double expected = n >= latency ? reference[n - latency] : 0.0;
+    error = std::max(error, std::fabs((double)output[n] - expected));
+  }
+  return error / peak;
+}
+
+// Run `impulseResponse` over `input` in blocks of `blockSize`, dropping
+// the final partial block. Returns how many samples were processed;
+// `idleBlocks` counts the blocks the idle gate skipped.
+size_t _Run(ImpulseResponse& impulseResponse, const std::vector<float>& input, size_t blockSize,
+            std::vector<float>& left, std::vector<float>& right, size_t& idleBlocks)
+{
+  const size_t length = input.size() / blockSize * blockSize;
+  left.assign(input.size(), 0.0f);
+  right.assign(input.size(), 0.0f);
+  idleBlocks = 0;
+  for (size_t done = 0; done < length; done += blockSize)
+  {
+    impulseResponse.ProcessBlock(&input[done], &left[done], &right[done], blockSize);
+    idleBlocks += impulseResponse.Idle() ? 1 : 0;
+  }
+  return length;
+}
+
+// As _Run(), over the block sizes of kBlockChanges.
+void _RunChanges(ImpulseResponse& impulseResponse, const std::vector<float>& input, std::vector<float>& left,
+                 std::vector<float>& right)
+{
+  left.assign(input.size(), 0.0f);
+  right.assign(input.size(), 0.0f);
+  size_t done = 0;
+  for (const BlockChange& change : kBlockChanges)
+    for (; done + change.blockSize <= change.end; done += change.blockSize)
+      impulseResponse.ProcessBlock(&input[done], &left[done], &right[done], change.blockSize);
+}
+
+// What a staging engine should output across kBlockChanges: the input up to
+// the first change (a whole number of partitions) convolved at no latency,
+// the rest `latency` samples late.
+std::vector<double> _ChangeReference(const std::vector<float>& ir, const std::vector<float>& input, size_t latency)
+{
+  const size_t change = kBlockChanges[0].end;
+  std::vector<float> before(input.size(), 0.0f), after(input.size(), 0.0f);
+  std::copy(input.begin(), input.begin() + change, before.begin());
+  std::copy(input.begin() + change, input.end(), after.begin() + change);
+  std::vector<double> output = _Reference(ir, before);
+  const std::vector<double> late = _Reference(ir, after);
+  for (size_t n = latency; n < output.size(); n++)
+    output[n] += late[n - latency];
+  return output;
+}
+
+// StaticImpulseResponse<MaxTaps, BlockSize> over `input`, dropping the
+// final partial block; returns the error against `reference`.
+template <size_t MaxTaps, size_t BlockSize>
+double _CheckStatic(const std::vector<float>& ir, const std::vector<float>& input,
+                    const std::vector<double>& reference)
+{
+  // Its arrays are far too big for the stack at the larger sizes
+  static StaticImpulseResponse<MaxTaps, BlockSize> impulseResponse;
+  impulseResponse.Init(ir.data(), ir.size());
+  std::vector<float> output(input.size(), 0.0f);
+  const size_t length = input.size() / BlockSize * BlockSize;
+  for (size_t done = 0; done < length; done += BlockSize)
+    impulseResponse.ProcessBlock(&input[done], &output[done]);
+  return _Error(output, reference, 0, length);
+}
+
+// `head` and `tail` are the multi-rate split of irA.
+void _Init(ImpulseResponse& impulseResponse, const Config& config, const std::vector<float>& irA,
+           const std::vector<float>& irB, const std::vector<float>& head, const std::vector<float>& tail,
+           size_t partitionSize)
+{
+  impulseResponse.SetPrecision(config.precision);
+  impulseResponse.SetHistoryMode(config.history);
+  if (config.engine == ImpulseResponse::Engine::MultiRate)
+  {
+    impulseResponse.Init(head.data(), head.size(), tail.data(), tail.size(), config.rate, kMultiRateSplit);
+  }
+  else if (config.engine == ImpulseResponse::Engine::Dual)
+  {
+    impulseResponse.Init(irA.data(), irA.size(), irB.data(), irB.size(),
+                         config.outputs == 2 ? ImpulseResponse::DualMode::Stereo : ImpulseResponse::DualMode::Blend,
+                         partitionSize);
+    impulseResponse.SetBlend(kDualBlend);
+  }
+  else
+  {
+    impulseResponse.Init(irA.data(), irA.size(), config.engine, partitionSize);
+  }
+  if (config.gate)
+    impulseResponse.SetSilenceThreshold(ImpulseResponse::kDefaultSilenceThreshold);
+}
+
+// The latency ProcessBlock() documents: none, except for the partition-
+// based engines on blocks that aren't a whole number of partitions.
+bool _Partitioned(const Config& config)
+{
+  return config.engine == ImpulseResponse::Engine::Partitioned || config.engine == ImpulseResponse::Engine::Dual;
+}
+
+size_t _Latency(const Config& config, size_t blockSize, size_t partitionSize)
+{
+  return _Partitioned(config) && blockSize % partitionSize != 0 ? partitionSize : 0;
+}
+} // namespace
+
+
+int main()
+{
+  std::srand(1);
+  const std::vector<float> irA = MakeIR(kIrLength);
+  // A shorter second IR, so the Dual engine's IRs differ in partition count
+  const std::vector<float> irB = MakeIR(kIrLength / 3);
+  const std::vector<float> input = _MakeInput(kNumSamples);
+  const std::vector<double> referenceA = _Reference(irA, input);
+  const std::vector<double> referenceB = _Reference(irB, input);
+  std::vector<double> referenceBlend(input.size());
+  for (size_t n = 0; n < input.size(); n++)
+    referenceBlend[n] = (1.0 - kDualBlend) * referenceA[n] + kDualBlend * referenceB[n];
+
+  // What the idle gate may leave out, relative to each reference
+  const double gateBound = ImpulseResponse::kDefaultSilenceThreshold
+                           * std::max(_SumAbs(irA) / _Peak(referenceA), _SumAbs(irB) / _Peak(referenceB));
+
+  int failures = 0;
+  std::printf("%-14s %6s %6s %8s %12s %6s\n", "engine", "block", "part", "latency", "error", "idle");
+  for (const Config& config : kConfigs)
+  {
+    std::vector<float> head, tail, equivalent, inputSplit;
+    std::vector<double> referenceSplit;
+    if (config.engine == ImpulseResponse::Engine::MultiRate)
+    {
+      _SplitMultiRate(irA, config.rate, head, tail, equivalent);
+      inputSplit = _Lowpassed(input, kMultiRateInputCutoff / (double)config.rate);
+      referenceSplit = _Reference(equivalent, inputSplit);
+    }
+    const std::vector<float>& configInput = inputSplit.empty() ? input : inputSplit;
+    const std::vector<double>& reference = referenceSplit.empty() ? referenceA : referenceSplit;
+
+    // Only the partition-based engines use the partition size
+    const size_t numPartitionSizes = _Partitioned(config) ? sizeof(kPartitionSizes) / sizeof(kPartitionSizes[0]) : 1;
+    for (size_t p = 0; p < numPartitionSizes; p++)
+    {
+      const size_t partitionSize = kPartitionSizes[p];
+      for (size_t blockSize : kBlockSizes)
+      {
+        ImpulseResponse impulseResponse;
+        _Init(impulseResponse, config, irA, irB, head, tail, partitionSize);
+        std::vector<float> left, right;
+        size_t idleBlocks;
+        const size_t length = _Run(impulseResponse, configInput, blockSize, left, right, idleBlocks);
+        const size_t latency = _Latency(config, blockSize, partitionSize);
+        double error;
+        if (config.engine != ImpulseResponse::Engine::Dual)
+          error = std::max(_Error(left, reference, latency, length), _Error(right, reference, latency, length));
+        else if (config.outputs == 2)
+          error = std::max(_Error(left, referenceA, latency, length), _Error(right, referenceB, latency, length));
+        else
+          error =
+            std::max(_Error(left, referenceBlend, latency, length), _Error(right, referenceBlend, latency, length));
+        const double idle = (double)(idleBlocks * blockSize) / (double)length;
+        const bool pass = config.gate ? error <= config.tolerance + gateBound && idleBlocks > 0
+                                      : error <= config.tolerance && idleBlocks == 0;
+        failures += pass ? 0 : 1;
+        char part[8] = "-";
+        if (_Partitioned(config))
+          std::snprintf(part, sizeof(part), "%zu", partitionSize);
+        std::printf("%-14s %6zu %6s %8zu %12.2e %5.0f%% %s\n", config.name, blockSize, part, latency, error,
+                    100.0 * idle, pass ? "ok" : "FAIL");
+      }
+    }
+  }
+
+  // Block size changes, on the ungated partition-based engines
+  const std::vector<double> changeA = _ChangeReference(irA, input, kChangePartitionSize);
+  const std::vector<double> changeB = _ChangeReference(irB, input, kChangePartitionSize);
+  std::vector<double> changeBlend(input.size());
+  for (size_t n = 0; n < input.size(); n++)
+    changeBlend[n] = (1.0 - kDualBlend) * changeA[n] + kDualBlend * changeB[n];
+  std::printf("\n%-14s %20s %12s\n", "engine", "blocks", "error");
+  for (const Config& config : kConfigs)
+  {
+    if (!_Partitioned(config) || config.gate)
+      continue;
+    ImpulseResponse impulseResponse;
+    _Init(impulseResponse, config, irA, irB, {}, {}, kChangePartitionSize);
+    std::vector<float> left, right;
+    _RunChanges(impulseResponse, input, left, right);
+    const std::vector<double>& referenceLeft =
+      config.engine != ImpulseResponse::Engine::Dual ? changeA : config.outputs == 2 ? changeA : changeBlend;
+    const std::vector<double>& referenceRight =
+      config.engine != ImpulseResponse::Engine::Dual ? changeA : config.outputs == 2 ? changeB : changeBlend;
+    const double error =
+      std::max(_Error(left, referenceLeft, 0, input.size()), _Error(right, referenceRight, 0, input.size()));
+    const bool pass = error <= config.tolerance;
+    failures += pass ? 0 : 1;
+    std::printf("%-14s %20s %12.2e %s\n", config.name, "64 -> 32 -> 8", error, pass ? "ok" : "FAIL");
+  }
+
+  // StaticImpulseResponse: irA zero padded to 1024 taps, and a full-length
+  // IR at the largest size
+  const std::vector<float> irLong = MakeIR(8192);
+  const std::vector<double> referenceLong = _Reference(irLong, input);
+  struct StaticCase
+  {
+    const char* name;
+    size_t taps;
+    size_t blockSize;
+    double error;
+  };
+  const StaticCase staticCases[] = {
+    {"static<1024,8>", kIrLength, 8, _CheckStatic<1024, 8>(irA, input, referenceA)},
+    {"static<8192,32>", irLong.size(), 32, _CheckStatic<8192, 32>(irLong, input, referenceLong)},
+  };
+  std::printf("\n%-16s %6s %6s %12s\n", "engine", "taps", "block", "error");
+  for (const StaticCase& staticCase : staticCases)
+  {
+    const bool pass = staticCase.error <= kStaticTolerance;
+    failures += pass ? 0 : 1;
+    std::printf("%-16s %6zu %6zu %12.2e %s\n", staticCase.name, staticCase.taps, staticCase.blockSize,
+                staticCase.error, pass ? "ok" : "FAIL");
+  }
+
+  if (failures)
+    std::printf("%d configuration(s) failed\n", failures);
+  return failures ? 1 : 0;
+}
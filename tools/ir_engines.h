@@ -0,0 +1,83 @@
+//
+//  ir_engines.h
+//
+//  The engine configurations and test IR shared by the host tools:
+//  ir_check runs every entry of kConfigs, ir_bench the ungated ones.
+//
+
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "ImpulseResponse/ImpulseResponse.h"
+
+
+namespace IREngines
+{
+struct Config
+{
+  const char* name;
+  ImpulseResponse::Engine engine;
+  ImpulseResponse::Precision precision;
+  HistoryMode history;
+  // MultiRate: tail decimation factor
+  size_t rate;
+  // Dual: 1 for a blend, 2 for stereo outputs
+  size_t outputs;
+  // ir_check: worst error relative to the reference peak
+  double tolerance;
+  // Run with the idle gate at ImpulseResponse::kDefaultSilenceThreshold
+  bool gate;
+};
+
+const Config kConfigs[] = {
+  {"direct", ImpulseResponse::Engine::Direct, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1, 1, 1e-4,
+   false},
+  // The baseline history layout, with its periodic rewind copy. ir_check's
+  // input is long enough for several rewinds.
+  {"direct-linear", ImpulseResponse::Engine::Direct, ImpulseResponse::Precision::Float, HistoryMode::Linear, 1, 1,
+   1e-4, false},
+  {"direct-q31", ImpulseResponse::Engine::Direct, ImpulseResponse::Precision::Q31, HistoryMode::Mirrored, 1, 1,
+   1e-4, false},
+  // 16-bit weights and inputs: quantisation noise around -70 dB of the peak
+  {"direct-q15", ImpulseResponse::Engine::Direct, ImpulseResponse::Precision::Q15, HistoryMode::Mirrored, 1, 1,
+   5e-4, false},
+  {"partitioned", ImpulseResponse::Engine::Partitioned, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1,
+   1, 1e-4, false},
+  {"hybrid", ImpulseResponse::Engine::Hybrid, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1, 1, 1e-4,
+   false},
+  {"multirate-2", ImpulseResponse::Engine::MultiRate, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 2, 1,
+   2e-3, false},
+  {"multirate-4", ImpulseResponse::Engine::MultiRate, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 4, 1,
+   2e-3, false},
+  {"dual-blend", ImpulseResponse::Engine::Dual, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1, 1, 1e-4,
+   false},
+  {"dual-stereo", ImpulseResponse::Engine::Dual, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1, 2,
+   1e-4, false},
+  {"direct-g", ImpulseResponse::Engine::Direct, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1, 1, 1e-4,
+   true},
+  {"partitioned-g", ImpulseResponse::Engine::Partitioned, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1,
+   1, 1e-4, true},
+  {"hybrid-g", ImpulseResponse::Engine::Hybrid, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1, 1, 1e-4,
+   true},
+  // No IR envelope: the gate waits out the full span
+  {"multirate-2-g", ImpulseResponse::Engine::MultiRate, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 2,
+   1, 2e-3, true},
+  {"dual-stereo-g", ImpulseResponse::Engine::Dual, ImpulseResponse::Precision::Float, HistoryMode::Mirrored, 1, 2,
+   1e-4, true},
+};
+
+// Exponentially decaying noise: no trailing zeros, so nothing is trimmed.
+inline std::vector<float> MakeIR(size_t length)
+{
+  std::vector<float> ir(length);
+  for (size_t i = 0; i < length; i++)
+  {
+    const float noise = (float)std::rand() / (float)RAND_MAX - 0.5f;
+    ir[i] = noise * std::exp(-4.0f * (float)i / (float)length);
+  }
+  return ir;
+}
+} // namespace IREngines
@@ -0,0 +1,592 @@
+//
+//  ir_render.cpp
+//
+//  Offline renderer: runs a WAV file through the MuleBox signal chain and
+//  writes the result. Built from the firmware's own DSP sources (make
+//  render), and driven one block at a time the way AudioCallback drives
+//  them: the BassBoost stage in an EffectChain, its gain on a
+//  ParameterRamp, then an IRManager with the compiled-in ir_collection,
+//  at a block size the IRs' partitions follow.
+//
+//  Not modelled: the main loop's control side (knob filtering, the control
+//  queue, effect routes; the boost simply stays routed), boost folding
+//  (BOOST_FOLD builds), the IR cache and the overload guard shortening the
+//  IRs. Parameter curves stand in for the knobs and switches.
+//
+//  Parameters are fixed values or automation curves of time:value
+//  breakpoints (seconds). The boost gain and dual blend are interpolated
+//  linearly between breakpoints, like turning the knob, and ramp per block
+//  as on the pedal. The IR steps to each new index, crossfading as on the
+//  pedal.
+//
+//  Usage: ir_render [options] input.wav output.wav
+//    --ir N|t:N,...         IR index, -1 for dry (default 0)
+//    --gain G|t:G,...       Boost wet gain, 0 to 3 (default 0)
+//    --blend B|t:B,...      Dual blend, 0 (IR N) to 1 (IR N + 1) (default 0)
+//    --engine E             direct, partitioned, hybrid, multirate,
+//                           dual-blend or dual-stereo (default: build default)
+//    --precision P          Direct engine format: float, q31 or q15
+//    --block N              Audio block size (default 8)
+//    --crossfade-ms MS      IR switch crossfade (default 20)
+//    --ramp-ms MS           Boost gain and blend ramp (default 5)
+//    --list                 List the compiled-in IRs and exit
+//
+//  The input must be 48 kHz, the rate the IRs were generated for. Only its
+//  first channel is used, as on the pedal. The dual engines pair IR N with
+//  IR N + 1, as TOGGLESWITCH_3 does. The output is 32-bit float, stereo for
+//  dual-stereo and mono otherwise, and runs on past the input, in whole
+//  blocks, until the longest IR's tail has rung out.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BassBoost.h"
+#include "ControlQueue.h"
+#include "EffectChain.h"
+#include "ImpulseResponse/BlockFloat.h"
+#include "ImpulseResponse/IRManager.h"
+#include "ImpulseResponse/ir_data.h"
+
+
+namespace
+{
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kMaxBlockSize = 256;
+// Longest IR the firmware plays (MAX_IR_BUFFER_SIZE): the tail rendered
+// past the end of the input.
+constexpr size_t kMaxIrLength = 8192;
+
+// The bass boost as an effect chain stage, as in AudioCallback.
+struct BoostStage
+{
+  BassBoost* boost;
+  float gainStart;
+  float gainEnd;
+};
+
+void _ProcessBoost(void* context, const float* inputs, float* outputs, size_t numFrames)
+{
+  const BoostStage* stage = static_cast<const BoostStage*>(context);
+  stage->boost->ProcessBlock(inputs, outputs, numFrames, stage->gainStart, stage->gainEnd);
+}
+
+void _ResetBoost(void* context)
+{
+  static_cast<BoostStage*>(context)->boost->Reset();
+}
+
+// A parameter over time: breakpoints sorted by time.
+struct Curve
+{
+  struct Point
+  {
+    double time;
+    float value;
+  };
+  std::vector<Point> points;
+
+  // Linear interpolation between breakpoints, held at both ends.
+  float Interpolate(double time) const
+  {
+    if (time <= points.front().time)
+      return points.front().value;
+    for (size_t i = 1; i < points.size(); i++)
+    {
+      if (time < points[i].time)
+      {
+        const Point& a = points[i - 1];
+        const Point& b = points[i];
+        return a.value + (float)((time - a.time) / (b.time - a.time)) * (b.value - a.value);
+      }
+    }
+    return points.back().value;
+  }
+
+  // Value of the last breakpoint at or before `time`.
+  float Step(double time) const
+  {
+    float value = points.front().value;
+    for (const Point& point : points)
+    {
+      if (point.time > time)
+        break;
+      value = point.value;
+    }
+    return value;
+  }
+};
+
+// Parse all of `text` as a number.
+bool _ParseNumber(const std::string& text, double& value)
+{
+  char* end = nullptr;
+  value = std::strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0';
+}
+
+// "V" or "T:V,T:V,...".
+bool _ParseCurve(const char* text, Curve& curve)
+{
+  curve.points.clear();
+  const std::string spec(text);
+  size_t start = 0;
+  while (start <= spec.size())
+  {
+    const size_t end = std::min(spec.find(',', start), spec.size());
+    const std::string item = spec.substr(start, end - start);
+    const size_t colon = item.find(':');
+    double time = 0.0, value = 0.0;
+    if (colon == std::string::npos ? !_ParseNumber(item, value)
+                                   : !_ParseNumber(item.substr(0, colon), time)
+                                       || !_ParseNumber(item.substr(colon + 1), value))
+      return false;
+    if (!curve.points.empty() && time < curve.points.back().time)
+      return false;
+    Curve::Point point;
+    point.time = time;
+    point.value = (float)value;
+    curve.points.push_back(point);
+    start = end + 1;
+  }
+  return !curve.points.empty();
+}
+
+uint32_t _ReadLE(const uint8_t* p, size_t bytes)
+{
+  uint32_t value = 0;
+  for (size_t i = 0; i < bytes; i++)
+    value |= (uint32_t)p[i] << (8 * i);
+  return value;
+}
+
+void _WriteLE(std::FILE* file, uint32_t value, size_t bytes)
+{
+  for (size_t i = 0; i < bytes; i++)
+    std::fputc((int)((value >> (8 * i)) & 0xFF), file);
+}
+
+// Read the first channel of a PCM (16/24/32-bit) or float WAV file.
+bool _ReadWav(const char* path, std::vector<float>& samples, uint32_t& sampleRate)
+{
+  std::FILE* file = std::fopen(path, "rb");
+  if (!file)
+  {
+    std::fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+  std::vector<uint8_t> bytes;
+  uint8_t buffer[65536];
+  size_t count;
+  while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    bytes.insert(bytes.end(), buffer, buffer + count);
+  std::fclose(file);
+
+  if (bytes.size() < 12 || std::memcmp(&bytes[0], "RIFF", 4) != 0 || std::memcmp(&bytes[8], "WAVE", 4) != 0)
+  {
+    std::fprintf(stderr, "%s is not a WAV file\n", path);
+    return false;
+  }
+
+  uint32_t format = 0, channels = 0, bits = 0;
+  const uint8_t* data = nullptr;
+  size_t dataBytes = 0;
+  for (size_t pos = 12; pos + 8 <= bytes.size();)
+  {
+    const uint32_t chunkBytes = _ReadLE(&bytes[pos + 4], 4);
+    const uint8_t* chunk = &bytes[pos + 8];
+    const size_t available = std::min<size_t>(chunkBytes, bytes.size() - pos - 8);
+    if (std::memcmp(&bytes[pos], "fmt ", 4) == 0 && available >= 16)
+    {
+      format = _ReadLE(chunk, 2);
+      channels = _ReadLE(chunk + 2, 2);
+      sampleRate = _ReadLE(chunk + 4, 4);
+      bits = _ReadLE(chunk + 14, 2);
+      // WAVE_FORMAT_EXTENSIBLE: the real format leads the subformat GUID
+      if (format == 0xFFFE && available >= 26)
+        format = _ReadLE(chunk + 24, 2);
+    }
+    else if (std::memcmp(&bytes[pos], "data", 4) == 0)
+    {
+      data = chunk;
+      dataBytes = available;
+    }
+    pos += 8 + chunkBytes + (chunkBytes & 1);
+  }
+
+  const bool pcm = format == 1 && (bits == 16 || bits == 24 || bits == 32);
+  const bool ieee = format == 3 && bits == 32;
+  if (!data || channels == 0 || (!pcm && !ieee))
+  {
+    std::fprintf(stderr, "%s: unsupported WAV format (%u-bit, format %u)\n", path, bits, format);
+    return false;
+  }
+
+  const size_t sampleBytes = bits / 8;
+  const size_t frameBytes = sampleBytes * channels;
+  const size_t frames = dataBytes / frameBytes;
+  samples.resize(frames);
+  for (size_t i = 0; i < frames; i++)
+  {
+    const uint8_t* p = data + i * frameBytes;
+    const uint32_t raw = _ReadLE(p, sampleBytes);
+    if (ieee)
+    {
+      float value;
+      std::memcpy(&value, &raw, sizeof(value));
+      samples[i] = value;
+    }
+    else
+    {
+      // Sign-extend from the top bit of the sample
+      const int32_t value = (int32_t)(raw << (32 - bits));
+      samples[i] = (float)value / 2147483648.0f;
+    }
+  }
+  return true;
+}
+
+// `samples` is interleaved, `channels` per frame.
+bool _WriteWav(const char* path, const std::vector<float>& samples, uint32_t channels, uint32_t sampleRate)
+{
+  std::FILE* file = std::fopen(path, "wb");
+  if (!file)
+  {
+    std::fprintf(stderr, "Can't create %s\n", path);
+    return false;
+  }
+  const uint32_t dataBytes = (uint32_t)(samples.size() * sizeof(float));
+  std::fwrite("RIFF", 1, 4, file);
+  _WriteLE(file, 36 + dataBytes, 4);
+  std::fwrite("WAVEfmt ", 1, 8, file);
+  _WriteLE(file, 16, 4);
+  _WriteLE(file, 3, 2);  // IEEE float
+  _WriteLE(file, channels, 2);
+  _WriteLE(file, sampleRate, 4);
+  _WriteLE(file, sampleRate * channels * sizeof(float), 4);
+  _WriteLE(file, channels * sizeof(float), 2);
+  _WriteLE(file, 32, 2);
+  std::fwrite("data", 1, 4, file);
+  _WriteLE(file, dataBytes, 4);
+  for (float sample : samples)
+  {
+    uint32_t raw;
+    std::memcpy(&raw, &sample, sizeof(raw));
+    _WriteLE(file, raw, 4);
+  }
+  const bool ok = std::ferror(file) == 0;
+  std::fclose(file);
+  return ok;
+}
+
+// Initialise `ir` from whichever copy of the IR the header holds, the way
+// the firmware does: a multi-rate split, else float taps, else the partition spectra when they
+// match, else decoded or dequantised taps. `taps` receives any expansion.
+bool _InitIr(ImpulseResponse* ir, const ImpulseResponseData::IRInfo& irInfo, ImpulseResponse::Engine engine,
+             size_t blockSize, std::vector<float>& taps)
+{
+  using namespace ImpulseResponseData;
+
+  const size_t length = irInfo.length;
+  if (irInfo.tail && irInfo.data)
+  {
+    ir->Init(irInfo.data, length, irInfo.tail, irInfo.tailLength, irInfo.tailRate, irInfo.tailSplit);
+    return true;
+  }
+  if (!irInfo.data && engine == ImpulseResponse::Engine::Partitioned && irInfo.format == IRFormat::PartitionedSpectra
+      && irInfo.partitionSize == blockSize)
+  {
+    ir->Init(reinterpret_cast<const std::complex<float>*>(irInfo.spectra), length, blockSize);
+    return true;
+  }
+
+  const float* data = irInfo.data;
+  if (!data)
+  {
+    taps.resize(length);
+    if (irInfo.codec != IRCodec::None && irInfo.packed)
+    {
+      BlockFloat::Decode(irInfo.packed, length, irInfo.codec == IRCodec::BlockFloat8 ? 8 : 16, taps.data());
+    }
+    else if (irInfo.q15)
+    {
+      for (size_t i = 0; i < length; i++)
+        taps[i] = std::ldexp((float)irInfo.q15[i], -(15 + irInfo.qShift));
+    }
+    else if (irInfo.q31)
+    {
+      for (size_t i = 0; i < length; i++)
+        taps[i] = std::ldexp((float)irInfo.q31[i], -(31 + irInfo.qShift));
+    }
+    else
+    {
+      return false;
+    }
+    data = taps.data();
+  }
+  ir->Init(data, length, engine, blockSize);
+  return true;
+}
+
+void _Usage()
+{
+  std::fprintf(stderr,
+               "Usage: ir_render [options] input.wav output.wav\n"
+               "  --ir N|t:N,...        IR index, -1 for dry (default 0)\n"
+               "  --gain G|t:G,...      Boost wet gain, 0 to %.0f (default 0)\n"
+               "  --blend B|t:B,...     Dual blend, 0 to 1 (default 0)\n"
+               "  --engine E            direct, partitioned, hybrid, multirate,\n"
+               "                        dual-blend or dual-stereo\n"
+               "  --precision P         Direct engine format: float, q31 or q15\n"
+               "  --block N             Audio block size, 1 to %zu (default 8)\n"
+               "  --crossfade-ms MS     IR switch crossfade (default 20)\n"
+               "  --ramp-ms MS          Boost gain and blend ramp (default 5)\n"
+               "  --list                List the compiled-in IRs\n",
+               (double)BassBoost::kMaxGain, kMaxBlockSize);
+}
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+  using namespace ImpulseResponseData;
+
+  Curve irCurve, gainCurve, blendCurve;
+  _ParseCurve("0", irCurve);
+  _ParseCurve("0", gainCurve);
+  _ParseCurve("0", blendCurve);
+  ImpulseResponse::Engine engine = ImpulseResponse::kDefaultEngine;
+  ImpulseResponse::DualMode dualMode = ImpulseResponse::DualMode::Blend;
+  ImpulseResponse::Precision precision = ImpulseResponse::kDefaultPrecision;
+  size_t blockSize = 8;
+  float crossfadeMs = 20.0f;
+  float rampMs = 5.0f;  // PARAM_RAMP_MS
+  const char* paths[2] = {nullptr, nullptr};
+  size_t numPaths = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg == "--list")
+    {
+      for (size_t n = 0; n < IR_COUNT; n++)
+        std::printf("%2zu  %s (%zu samples)\n", n, ir_collection[n].name, ir_collection[n].length);
+      return 0;
+    }
+    else if (arg.compare(0, 2, "--") == 0 && !value)
+    {
+      _Usage();
+      return 1;
+    }
+    else if (arg == "--ir" || arg == "--gain" || arg == "--blend")
+    {
+      Curve& curve = arg == "--ir" ? irCurve : arg == "--gain" ? gainCurve : blendCurve;
+      if (!_ParseCurve(value, curve))
+      {
+        std::fprintf(stderr, "Bad %s curve: %s\n", arg.c_str(), value);
+        return 1;
+      }
+      i++;
+    }
+    else if (arg == "--engine")
+    {
+      const std::string name = value;
+      if (name == "direct")
+        engine = ImpulseResponse::Engine::Direct;
+      else if (name == "partitioned")
+        engine = ImpulseResponse::Engine::Partitioned;
+      else if (name == "hybrid")
+        engine = ImpulseResponse::Engine::Hybrid;
+      else if (name == "multirate")
+        engine = ImpulseResponse::Engine::MultiRate;
+      else if (name == "dual-blend" || name == "dual-stereo")
+      {
+        engine = ImpulseResponse::Engine::Dual;
+        dualMode = name == "dual-stereo" ? ImpulseResponse::DualMode::Stereo : ImpulseResponse::DualMode::Blend;
+      }
+      else
+      {
+        _Usage();
+        return 1;
+      }
+      i++;
+    }
+    else if (arg == "--precision")
+    {
+      const std::string name = value;
+      if (name == "float")
+        precision = ImpulseResponse::Precision::Float;
+      else if (name == "q31")
+        precision = ImpulseResponse::Precision::Q31;
+      else if (name == "q15")
+        precision = ImpulseResponse::Precision::Q15;
+      else
+      {
+        _Usage();
+        return 1;
+      }
+      i++;
+    }
+    else if (arg == "--block")
+    {
+      blockSize = (size_t)std::atoi(value);
+      i++;
+    }
+    else if (arg == "--crossfade-ms")
+    {
+      crossfadeMs = (float)std::atof(value);
+      i++;
+    }
+    else if (arg == "--ramp-ms")
+    {
+      rampMs = (float)std::atof(value);
+      i++;
+    }
+    else if (numPaths < 2 && arg.compare(0, 2, "--") != 0)
+    {
+      paths[numPaths++] = argv[i];
+    }
+    else
+    {
+      _Usage();
+      return 1;
+    }
+  }
+  // The partitioned engines need a power-of-two partition
+  const bool powerOfTwo = blockSize > 0 && (blockSize & (blockSize - 1)) == 0;
+  const bool partitioned = engine == ImpulseResponse::Engine::Partitioned || engine == ImpulseResponse::Engine::Dual;
+  if (numPaths != 2 || blockSize == 0 || blockSize > kMaxBlockSize || (partitioned && !powerOfTwo))
+  {
+    _Usage();
+    return 1;
+  }
+
+  std::vector<float> input;
+  uint32_t sampleRate = 0;
+  if (!_ReadWav(paths[0], input, sampleRate))
+    return 1;
+  if (sampleRate != kSampleRate)
+  {
+    std::fprintf(stderr, "%s is %u Hz; the IRs are %u Hz\n", paths[0], sampleRate, kSampleRate);
+    return 1;
+  }
+
+  BassBoost bassBoost;
+  bassBoost.Init((float)kSampleRate);
+  BoostStage boostStage = {&bassBoost, 0.0f, 0.0f};
+  EffectChain<1, kMaxBlockSize> effectChain;
+  const uint32_t boostBit = effectChain.AddStage(_ProcessBoost, &boostStage, _ResetBoost);
+  const size_t rampFrames = (size_t)(rampMs * 0.001f * kSampleRate);
+  ParameterRamp boostGainRamp, irBlendRamp;
+  boostGainRamp.Init(0.0f, rampFrames);
+  irBlendRamp.Init(0.0f, rampFrames);
+  IRManager irManager;
+  const size_t crossfadeBlocks = (size_t)(crossfadeMs * 0.001f * kSampleRate) / blockSize;
+  irManager.Init(kMaxBlockSize, std::max<size_t>(crossfadeBlocks, 1));
+
+  // Whole blocks only, as the codec delivers them, running on until the
+  // tail of the longest IR has rung out
+  const size_t numBlocks = (input.size() + kMaxIrLength + blockSize - 1) / blockSize;
+  input.resize(numBlocks * blockSize, 0.0f);
+  const uint32_t channels = engine == ImpulseResponse::Engine::Dual && dualMode == ImpulseResponse::DualMode::Stereo
+                              ? 2 : 1;
+  std::vector<float> output(input.size() * channels, 0.0f);
+  std::vector<float> left(blockSize), right(blockSize);
+  std::vector<float> taps;
+  int currentIr = -2;  // Nothing loaded yet: both slots start dry
+  float sentGain = 0.0f, sentBlend = 0.0f;
+  // Fixed-point clips over the render. Each load restarts the playing
+  // IR's count, so add up its increases.
+  unsigned long clips = 0;
+  uint32_t lastClips = 0;
+
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+  for (size_t pos = 0; pos < input.size(); pos += blockSize)
+  {
+    const double time = (double)pos / kSampleRate;
+
+    // Control side, as the main loop would between callbacks. A switch
+    // waits for the previous one to finish, like on the pedal.
+    int irIndex = (int)std::lround(irCurve.Step(time));
+    if (irIndex < 0 || irIndex >= (int)IR_COUNT)
+      irIndex = -1;
+    if (irIndex != currentIr && !irManager.Busy())
+    {
+      if (irIndex < 0)
+      {
+        irManager.CommitBypass();
+      }
+      else
+      {
+        ImpulseResponse* ir = irManager.BeginLoad();
+        ir->SetPrecision(precision);
+        const IRInfo& irA = ir_collection[irIndex];
+        const IRInfo& irB = ir_collection[(irIndex + 1) % IR_COUNT];
+        bool loaded;
+        if (engine == ImpulseResponse::Engine::Dual && IR_COUNT > 1 && irA.data && irB.data)
+        {
+          ir->Init(irA.data, std::min(irA.length, kMaxIrLength), irB.data, std::min(irB.length, kMaxIrLength),
+                   dualMode, blockSize);
+          loaded = true;
+        }
+        else
+        {
+          // Like the pedal, a pair without float taps plays the first IR mono
+          const ImpulseResponse::Engine single =
+            engine == ImpulseResponse::Engine::Dual ? ImpulseResponse::Engine::Partitioned : engine;
+          loaded = _InitIr(ir, irA, single, blockSize, taps);
+        }
+        if (!loaded)
+          std::fprintf(stderr, "IR %d has no data this engine can use, running dry\n", irIndex);
+        irManager.CommitLoad(!loaded);
+      }
+      currentIr = irIndex;
+    }
+    // Sent only when they change, as pushControl() does
+    const float maxGain = BassBoost::kMaxGain;
+    const float wetGain = std::max(0.0f, std::min(maxGain, gainCurve.Interpolate(time)));
+    const float blend = std::max(0.0f, std::min(1.0f, blendCurve.Interpolate(time)));
+    if (wetGain != sentGain)
+      boostGainRamp.SetTarget(wetGain);
+    if (blend != sentBlend)
+      irBlendRamp.SetTarget(blend);
+    sentGain = wetGain;
+    sentBlend = blend;
+
+    // Audio side, as AudioCallback
+    const bool boostNeeded = irManager.BeginBlock(blockSize);
+    boostStage.gainStart = boostGainRamp.Value();
+    boostStage.gainEnd = boostGainRamp.Advance(blockSize);
+    const float* chained = effectChain.Process(&input[pos], blockSize, boostNeeded ? 0 : boostBit);
+    irManager.SetBlend(irBlendRamp.Advance(blockSize));
+    irManager.ProcessBlock(&input[pos], chained, left.data(), right.data(), blockSize);
+    const uint32_t irClips = irManager.ClipCount();
+    clips += irClips >= lastClips ? irClips - lastClips : irClips;
+    lastClips = irClips;
+    for (size_t i = 0; i < blockSize; i++)
+    {
+      output[(pos + i) * channels] = left[i];
+      if (channels == 2)
+        output[(pos + i) * channels + 1] = right[i];
+    }
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  if (!_WriteWav(paths[1], output, channels, kSampleRate))
+    return 1;
+  const double audioSeconds = (double)input.size() / kSampleRate;
+  std::fprintf(stderr, "Rendered %.2f s in %.3f s (%.1fx realtime, %.1f ns/sample)\n", audioSeconds, seconds,
+               seconds > 0.0 ? audioSeconds / seconds : 0.0, input.empty() ? 0.0 : seconds * 1e9 / input.size());
+  if (clips)
+    std::fprintf(stderr, "%lu input samples clipped in the fixed-point FIR\n", clips);
+  return 0;
+}
@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+Trace Capture Converter for MuleBox
+
+Turns the binary event trace a `make TRACE=1` build streams over USB serial
+into a Chrome trace (open it in chrome://tracing or https://ui.perfetto.dev)
+and/or a text summary of how long each stage and task took.
+
+The capture is the raw serial stream, e.g. from `cat /dev/ttyACM0 > trace.bin`
+after `stty -F /dev/ttyACM0 raw`. Text printed by CPU_PROFILE builds may be
+interleaved with the trace frames; it is skipped.
+
+Usage:
+    python3 trace_to_chrome.py trace.bin -o trace.json
+    python3 trace_to_chrome.py trace.bin --summary
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+# Frame layout, matches src/Trace.h
+FRAME_MAGIC = b'MTRC'
+FRAME_VERSION = 1
+FRAME_HEADER = struct.Struct('<4sHHII')   # magic, version, count, lost, clock Hz
+RECORD = struct.Struct('<IBBH')           # cycles, event, kind, sequence
+MAX_FRAME_RECORDS = 256                   # Trace::kFrameRecords
+
+# Trace::Event, in order. The audio side and the main loop get a track each.
+EVENTS = [
+    ('AudioCallback', 'audio'),
+    ('BassBoost', 'audio'),
+    ('Convolution', 'audio'),
+    ('HistoryRewind', 'audio'),
+    ('IrSwap', 'audio'),
+    ('ControlTask', 'main'),
+    ('LedTask', 'main'),
+    ('SettingsTask', 'main'),
+    ('OverloadTask', 'main'),
+    ('IrLoad', 'main'),
+    ('IrInit', 'main'),
+    ('SettingsWrite', 'main'),
+    ('BoostFold', 'main'),
+]
+KIND_BEGIN, KIND_END, KIND_INSTANT = 0, 1, 2
+TRACKS = {'audio': 1, 'main': 2}
+
+
+def read_frames(data):
+    """
+    Find the trace frames in a serial capture.
+
+    Args:
+        data: Raw bytes of the capture
+
+    Returns:
+        tuple: (records, lost, clock_hz) where records is a list of
+        (cycles, event, kind, sequence) in the order they were recorded
+    """
+    records = []
+    lost = 0
+    clock_hz = None
+    pos = 0
+    while True:
+        pos = data.find(FRAME_MAGIC, pos)
+        if pos < 0 or pos + FRAME_HEADER.size > len(data):
+            break
+        _, version, count, frame_lost, frame_clock = FRAME_HEADER.unpack_from(data, pos)
+        end = pos + FRAME_HEADER.size + count * RECORD.size
+        if version != FRAME_VERSION or count == 0 or count > MAX_FRAME_RECORDS or end > len(data):
+            pos += 1  # Text that happens to contain the magic, or a cut-off frame
+            continue
+        for i in range(count):
+            records.append(RECORD.unpack_from(data, pos + FRAME_HEADER.size + i * RECORD.size))
+        lost = frame_lost
+        clock_hz = frame_clock
+        pos = end
+    return records, lost, clock_hz
+
+
+def to_microseconds(records, clock_hz):
+    """
+    Unwrap the 32-bit cycle counter into microseconds from the first record.
+
+    Records are in recording order, but one that was interrupted between
+    reading the counter and publishing can carry a slightly later time than
+    the next, so deltas are taken as signed.
+
+    Returns:
+        list: (time_us, event, kind) per record
+    """
+    events = []
+    elapsed = 0
+    last = None
+    for cycles, event, kind, _ in records:
+        if last is not None:
+            delta = (cycles - last) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            elapsed += delta
+        last = cycles
+        events.append((elapsed * 1e6 / clock_hz, event, kind))
+    return events
+
+
+def event_info(event):
+    """Name and track of an event number."""
+    if event < len(EVENTS):
+        return EVENTS[event]
+    return (f'Event{event}', 'main')
+
+
+def chrome_trace(events):
+    """
+    Build a Chrome trace (JSON object format) from unwrapped events.
+    """
+    trace = []
+    for track, tid in TRACKS.items():
+        trace.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': tid, 'args': {'name': track}})
+    for time_us, event, kind in events:
+        name, track = event_info(event)
+        entry = {'name': name, 'pid': 1, 'tid': TRACKS[track], 'ts': round(time_us, 3)}
+        if kind == KIND_BEGIN:
+            entry['ph'] = 'B'
+        elif kind == KIND_END:
+            entry['ph'] = 'E'
+        else:
+            entry['ph'] = 'i'
+            entry['s'] = 't'
+        trace.append(entry)
+    return {'traceEvents': trace, 'displayTimeUnit': 'ns'}
+
+
+def durations(events):
+    """
+    Pair begin and end events per track.
+
+    Returns:
+        list: (name, start_us, duration_us) per completed span
+    """
+    spans = []
+    open_spans = {track: [] for track in TRACKS}
+    for time_us, event, kind in events:
+        name, track = event_info(event)
+        stack = open_spans[track]
+        if kind == KIND_BEGIN:
+            stack.append((name, time_us))
+        elif kind == KIND_END:
+            # Unwind to the matching begin; anything left open above it lost
+            # its end to a dropped record
+            while stack:
+                open_name, start = stack.pop()
+                if open_name == name:
+                    spans.append((name, start, time_us - start))
+                    break
+    return spans
+
+
+def print_summary(events, lost, top):
+    """
+    Print per-event timing and the slowest audio callbacks, with the main
+    loop spans they overlapped.
+    """
+    spans = durations(events)
+    total_us = events[-1][0] - events[0][0] if events else 0.0
+    print(f"{len(events)} records over {total_us / 1000:.1f} ms, {lost} lost")
+    print(f"{'event':<16}{'count':>8}{'avg us':>10}{'max us':>10}")
+    by_name = {}
+    for name, _, duration in spans:
+        by_name.setdefault(name, []).append(duration)
+    for name, _ in EVENTS:
+        if name in by_name:
+            values = by_name[name]
+            print(f"{name:<16}{len(values):>8}{sum(values) / len(values):>10.1f}{max(values):>10.1f}")
+    instants = {}
+    for _, event, kind in events:
+        if kind == KIND_INSTANT:
+            name = event_info(event)[0]
+            instants[name] = instants.get(name, 0) + 1
+    for name, count in instants.items():
+        print(f"{name:<16}{count:>8}")
+
+    callbacks = sorted((s for s in spans if s[0] == 'AudioCallback'), key=lambda s: -s[2])[:top]
+    tracks = dict(EVENTS)
+    main_spans = [s for s in spans if tracks.get(s[0]) == 'main']
+    if callbacks:
+        print(f"\nSlowest {len(callbacks)} audio callbacks:")
+    for _, start, duration in callbacks:
+        overlapping = sorted({name for name, s, d in main_spans if s < start + duration and s + d > start})
+        during = ', '.join(overlapping) if overlapping else '-'
+        print(f"  at {start / 1000:10.3f} ms: {duration:7.1f} us, during {during}")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert a MuleBox TRACE=1 serial capture to a Chrome trace',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  # Capture a few seconds, then convert
+  stty -F /dev/ttyACM0 raw && timeout 5 cat /dev/ttyACM0 > trace.bin
+  python3 trace_to_chrome.py trace.bin -o trace.json
+
+  # Per-stage timings and what the slowest callbacks ran alongside
+  python3 trace_to_chrome.py trace.bin --summary --top 20
+        """
+    )
+    parser.add_argument('capture', help='Raw serial capture from a TRACE=1 build')
+    parser.add_argument('-o', '--output', help='Chrome trace JSON file to write')
+    parser.add_argument('--summary', action='store_true', help='Print a text summary')
+    parser.add_argument('--top', type=int, default=10,
+                        help='Slowest audio callbacks to list in the summary (default: 10)')
+    args = parser.parse_args()
+
+    with open(args.capture, 'rb') as f:
+        data = f.read()
+    records, lost, clock_hz = read_frames(data)
+    if not records:
+        print(f"Error: no trace frames in {args.capture}", file=sys.stderr)
+        return 1
+
+    events = to_microseconds(records, clock_hz)
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(chrome_trace(events), f)
+        print(f"Wrote {len(events)} events to {args.output}")
+    if args.summary or not args.output:
+        print_summary(events, lost, args.top)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -3,7 +3,8 @@
 WAV to IR Header Converter for MuleBox
 
 Converts WAV files (impulse responses) to C++ header format for embedding
-in firmware. Supports up to 12 IRs for cabinet simulation.
+in firmware. Supports up to 36 IRs for cabinet simulation: three banks
+(toggle switch 1) of 12 positions (the rotary selector).
 
 Usage:
     python3 wav_to_ir_header.py [wav_files...] -o output.h
@@ -13,6 +14,8 @@ Example:
 """
 
 import argparse
+import cmath
+import math
 import wave
 import struct
 import os
@@ -23,7 +26,17 @@ from pathlib import Path
 SAMPLE_RATE = 48000
 MAX_IR_LENGTH_MS = 170  # Maximum IR length in milliseconds
 MAX_IR_SAMPLES = int((MAX_IR_LENGTH_MS / 1000.0) * SAMPLE_RATE)  # 8,160 samples
-MAX_IR_COUNT = 12
+IR_BANK_SIZE = 12  # Rotary positions per bank
+IR_BANK_COUNT = 3  # Toggle switch positions
+MAX_IR_COUNT = IR_BANK_SIZE * IR_BANK_COUNT
+BLOCK_FLOAT_SIZE = 16  # Taps per shared exponent, matches BlockFloat::kBlockSize
+DEFAULT_TRIM_DB = -60.0  # Residual energy below which the tail is dropped
+DEFAULT_FADE_MS = 2.0    # Fade-out applied at the trim point
+DEFAULT_SPLIT_MS = 20.0  # Multi-rate: where the reduced-rate tail takes over
+MULTIRATE_FADE = 64      # Multi-rate: head/tail crossfade length in samples
+# Multi-rate filter delay per unit of rate, matches
+# MultiRateConvolver::kFilterTapsPerRate. The split can't come earlier.
+MULTIRATE_FILTER_TAPS_PER_RATE = 16
 
 
 def read_wav_file(filepath):
@@ -113,6 +126,119 @@ def trim_or_pad_ir(samples, target_length=MAX_IR_SAMPLES):
         return samples
 
 
+def find_trim_point(samples, threshold_db=DEFAULT_TRIM_DB):
+    """
+    Find where the rest of the IR is below the noise floor.
+
+    Integrates the energy backwards from the end (Schroeder integration) and
+    returns the first sample after which the remaining energy is less than
+    threshold_db relative to the total.
+
+    Args:
+        samples: List of float samples
+        threshold_db: Residual energy threshold in dB (negative)
+
+    Returns:
+        int: Sample count to keep (at least 1)
+    """
+    total = sum(v * v for v in samples)
+    if total == 0.0:
+        return 1
+    limit = total * 10.0 ** (threshold_db / 10.0)
+
+    remaining = 0.0
+    for i in range(len(samples) - 1, -1, -1):
+        remaining += samples[i] * samples[i]
+        if remaining > limit:
+            return i + 1
+    return len(samples)
+
+
+def auto_trim_ir(samples, threshold_db=DEFAULT_TRIM_DB, fade_ms=DEFAULT_FADE_MS):
+    """
+    Trim the IR at its noise-floor point with a raised-cosine fade-out.
+
+    Args:
+        samples: List of float samples
+        threshold_db: Residual energy threshold in dB, see find_trim_point()
+        fade_ms: Fade-out length in milliseconds, ending at the trim point
+
+    Returns:
+        list: Trimmed samples
+    """
+    length = find_trim_point(samples, threshold_db)
+    trimmed = list(samples[:length])
+
+    fade = min(int(fade_ms / 1000.0 * SAMPLE_RATE), length // 2)
+    for i in range(fade):
+        # Gain runs from just under 1 down to just above 0
+        gain = 0.5 * (1.0 + math.cos(math.pi * (i + 1) / (fade + 1)))
+        trimmed[length - fade + i] *= gain
+
+    if length < len(samples):
+        print(f"  Auto-trim at {threshold_db:.0f} dB: {len(samples)} -> {length} samples "
+              f"({length / SAMPLE_RATE * 1000:.1f}ms, {len(samples) / length:.1f}x shorter)")
+    return trimmed
+
+
+def lowpass_taps(num_taps, cutoff):
+    """Blackman-windowed sinc lowpass at cutoff cycles/sample, unity DC gain."""
+    center = (num_taps - 1) / 2.0
+    taps = []
+    for k in range(num_taps):
+        t = k - center
+        sinc = 2.0 * cutoff if t == 0 else math.sin(2.0 * math.pi * cutoff * t) / (math.pi * t)
+        phase = 2.0 * math.pi * k / (num_taps - 1)
+        taps.append(sinc * (0.42 - 0.5 * math.cos(phase) + 0.08 * math.cos(2.0 * phase)))
+    total = sum(taps)
+    return [v / total for v in taps]
+
+
+def split_multirate(samples, rate, split_ms=DEFAULT_SPLIT_MS):
+    """
+    Split the IR for the multi-rate engine (MultiRateConvolver).
+
+    The head is the IR up to the split point plus MULTIRATE_FADE samples
+    fading out. The tail starts at the split with the complementary fade-in,
+    is lowpassed (zero phase) below the reduced Nyquist frequency and keeps
+    every rate-th sample, scaled by the rate.
+
+    Args:
+        samples: List of float samples
+        rate: Decimation factor of the tail (2 or 4)
+        split_ms: Split point in milliseconds, rounded to a multiple of rate
+
+    Returns:
+        tuple: (head, tail, split); tail is None if the IR ends before the split
+    """
+    split = max(int(round(split_ms / 1000.0 * SAMPLE_RATE / rate)) * rate,
+                MULTIRATE_FILTER_TAPS_PER_RATE * rate)
+    if split >= len(samples):
+        return list(samples), None, 0
+
+    fade = min(MULTIRATE_FADE, len(samples) - split)
+    head = list(samples[:split + fade])
+    tail = list(samples[split:])
+    for i in range(fade):
+        # Raised-cosine pair summing to 1 over the overlap
+        gain = 0.5 * (1.0 + math.cos(math.pi * (i + 0.5) / fade))
+        head[split + i] *= gain
+        tail[i] *= 1.0 - gain
+
+    taps = lowpass_taps(64 * rate + 1, 0.45 / rate)
+    center = len(taps) // 2
+    decimated = []
+    for n in range(0, len(tail), rate):
+        acc = 0.0
+        for k in range(max(0, n + center - len(tail) + 1), min(len(taps), n + center + 1)):
+            acc += taps[k] * tail[n + center - k]
+        decimated.append(rate * acc)
+
+    print(f"  Multi-rate split at {split} samples ({split / SAMPLE_RATE * 1000:.1f}ms): "
+          f"{len(head)} head taps, {len(decimated)} tail taps at 1/{rate} rate")
+    return head, decimated, split
+
+
 def format_cpp_raw_array(samples, name, indent=0):
     """
     Format samples as C raw array with QSPI section attribute.
@@ -147,6 +273,169 @@ def format_cpp_raw_array(samples, name, indent=0):
     return '\n'.join(lines)
 
 
+def weight_shift(samples):
+    """
+    Shift that normalises the largest |tap| into [0.5, 1).
+
+    Matches FixedPointFir::WeightShift() so offline and on-device
+    quantisation agree.
+
+    Args:
+        samples: List of float samples
+
+    Returns:
+        int: Shift such that weight = q * 2^-(frac_bits + shift)
+    """
+    peak = max((abs(v) for v in samples), default=0.0)
+    if peak == 0.0:
+        return 0
+    _, exponent = math.frexp(peak)
+    return -exponent
+
+
+def quantize_ir(samples, frac_bits, shift):
+    """
+    Quantise float samples to saturated signed fixed point.
+
+    Args:
+        samples: List of float samples
+        frac_bits: 15 for Q15, 31 for Q31
+        shift: Per-IR weight shift from weight_shift()
+
+    Returns:
+        list: Integer samples
+    """
+    scale = 2.0 ** (frac_bits + shift)
+    max_val = (1 << frac_bits) - 1
+    min_val = -(1 << frac_bits)
+    # C's roundf() rounds halfway cases away from zero
+    return [max(min_val, min(max_val, int(math.copysign(math.floor(abs(v * scale) + 0.5), v))))
+            for v in samples]
+
+
+def encode_block_float(samples, mantissa_bits):
+    """
+    Encode samples in the block floating point format of BlockFloat.h.
+
+    Each block of BLOCK_FLOAT_SIZE taps shares one exponent, chosen so the
+    block's peak uses the full mantissa range: tap = mantissa * 2^exponent.
+
+    Args:
+        samples: List of float samples
+        mantissa_bits: 8 or 16
+
+    Returns:
+        bytes: Packed blocks, zero padded to a whole block
+    """
+    max_val = (1 << (mantissa_bits - 1)) - 1
+    min_val = -(1 << (mantissa_bits - 1))
+    out = bytearray()
+    for start in range(0, len(samples), BLOCK_FLOAT_SIZE):
+        block = list(samples[start:start + BLOCK_FLOAT_SIZE])
+        block += [0.0] * (BLOCK_FLOAT_SIZE - len(block))
+        peak = max(abs(v) for v in block)
+        if peak == 0.0:
+            exponent = 0
+        else:
+            exponent = math.frexp(peak)[1] - (mantissa_bits - 1)
+            exponent = max(-128, min(127, exponent))
+        scale = 2.0 ** -exponent
+        # C's roundf() rounds halfway cases away from zero
+        mantissas = [max(min_val, min(max_val, int(math.copysign(math.floor(abs(v * scale) + 0.5), v))))
+                     for v in block]
+        if mantissa_bits == 8:
+            out += struct.pack('<b', exponent)
+            out += struct.pack(f'<{BLOCK_FLOAT_SIZE}b', *mantissas)
+        else:
+            out += struct.pack('<bx', exponent)
+            out += struct.pack(f'<{BLOCK_FLOAT_SIZE}h', *mantissas)
+    return bytes(out)
+
+
+def format_cpp_int_array(values, name, ctype, indent=0):
+    """
+    Format integer samples as C raw array with QSPI section attribute.
+
+    Args:
+        values: List of integer samples
+        name: Variable name
+        ctype: C element type (int16_t or int32_t)
+        indent: Indentation level
+
+    Returns:
+        str: Formatted C++ code
+    """
+    indent_str = ' ' * indent
+    lines = [
+        f"{indent_str}// Stored in QSPI flash",
+        f'{indent_str}__attribute__((section(".qspiflash_data"))) __attribute__((aligned(4)))',
+        f"{indent_str}const {ctype} {name}[{len(values)}] = {{"
+    ]
+
+    values_per_line = {'uint8_t': 16, 'int16_t': 12}.get(ctype, 8)
+    for i in range(0, len(values), values_per_line):
+        chunk = values[i:i + values_per_line]
+        lines.append(f"{indent_str}    {', '.join(str(v) for v in chunk)},")
+
+    # Remove trailing comma from last line
+    lines[-1] = lines[-1].rstrip(',')
+
+    lines.append(f"{indent_str}}};")
+
+    return '\n'.join(lines)
+
+
+def fft(values):
+    """
+    Radix-2 complex FFT (forward, unnormalised).
+
+    Args:
+        values: List of complex values, length a power of two
+
+    Returns:
+        list: Transformed values
+    """
+    n = len(values)
+    if n == 1:
+        return list(values)
+    even = fft(values[0::2])
+    odd = fft(values[1::2])
+    out = [0j] * n
+    for k in range(n // 2):
+        t = cmath.exp(-2j * math.pi * k / n) * odd[k]
+        out[k] = even[k] + t
+        out[k + n // 2] = even[k] - t
+    return out
+
+
+def partition_spectra(samples, partition_size):
+    """
+    Pre-transform the IR in the layout PartitionedConvolver expects.
+
+    Each partition of partition_size taps is zero padded to twice its size
+    and transformed; bins 0..partition_size are kept and scaled by 1/FFT size
+    (the engine folds the inverse FFT normalisation into the IR spectra).
+
+    Args:
+        samples: List of float samples
+        partition_size: Engine partition size (the audio block size), power of two
+
+    Returns:
+        list: Interleaved re/im floats, partitions x (partition_size + 1) bins
+    """
+    fft_size = 2 * partition_size
+    num_partitions = max(1, (len(samples) + partition_size - 1) // partition_size)
+    out = []
+    for p in range(num_partitions):
+        chunk = samples[p * partition_size:(p + 1) * partition_size]
+        padded = [complex(v) for v in chunk] + [0j] * (fft_size - len(chunk))
+        bins = fft(padded)[:partition_size + 1]
+        for b in bins:
+            out.append(b.real / fft_size)
+            out.append(b.imag / fft_size)
+    return out
+
+
 def sanitize_name(filepath):
     """Convert filepath to valid C++ identifier."""
     name = Path(filepath).stem  # Get filename without extension
@@ -158,13 +447,24 @@ def sanitize_name(filepath):
     return name.lower()
 
 
-def generate_header(ir_data, output_path):
+def generate_header(ir_data, output_path, emit_float=True, emit_q15=False, emit_q31=False,
+                    spectra_partition=0, compress_bits=0, multirate=0, split_ms=DEFAULT_SPLIT_MS):
     """
     Generate C++ header file with IR data stored in QSPI flash.
 
     Args:
         ir_data: List of (name, samples) tuples
         output_path: Output header file path
+        emit_float: Emit the float arrays
+        emit_q15: Emit Q15 arrays alongside (or instead of) the float data
+        emit_q31: Emit Q31 arrays alongside (or instead of) the float data
+        spectra_partition: If non-zero, also emit partitioned spectra for this
+            partition size
+        compress_bits: If non-zero, also emit block floating point data with
+            this many mantissa bits (8 or 16)
+        multirate: If non-zero, split each IR into a full-rate head (the float
+            data) and a tail at 1/multirate of the sample rate
+        split_ms: Multi-rate split point in milliseconds
     """
     guard_name = "IR_DATA_H"
 
@@ -178,37 +478,109 @@ def generate_header(ir_data, output_path):
         f"#define {guard_name}",
         "",
         "#include <cstddef>",
+        "#include <cstdint>",
         "",
         "namespace ImpulseResponseData {",
         "",
     ]
 
     # Add IR metadata structure
+    lines.append("// What IRInfo::spectra holds")
+    lines.append("enum class IRFormat : uint8_t {")
+    lines.append("    Raw,                 // Time-domain data only")
+    lines.append("    PartitionedSpectra,  // Plus pre-transformed partitions for the partitioned engine")
+    lines.append("};")
+    lines.append("")
+    lines.append("// Compressed copy in IRInfo::packed (see BlockFloat.h)")
+    lines.append("enum class IRCodec : uint8_t {")
+    lines.append("    None,")
+    lines.append("    BlockFloat8,   // 8-bit mantissas, 8.5 bits per tap")
+    lines.append("    BlockFloat16,  // 16-bit mantissas, 17 bits per tap")
+    lines.append("};")
+    lines.append("")
     lines.append("// IR metadata")
     lines.append("struct IRInfo {")
     lines.append("    const char* name;")
-    lines.append("    const float* data;  // Pointer to QSPI data")
+    lines.append("    const float* data;  // Pointer to QSPI data (nullptr if not generated)")
     lines.append("    size_t length;      // Sample count")
+    lines.append("    const int16_t* q15; // Optional Q15 copy in QSPI (nullptr if not generated)")
+    lines.append("    const int32_t* q31; // Optional Q31 copy in QSPI (nullptr if not generated)")
+    lines.append("    int qShift;         // Fixed-point weight = q * 2^-(15 or 31 + qShift)")
+    lines.append("    IRFormat format;")
+    lines.append("    const float* spectra;  // Interleaved re/im, partitions x (partitionSize + 1) bins")
+    lines.append("    size_t partitionSize;  // Partition size the spectra were computed for")
+    lines.append("    IRCodec codec;")
+    lines.append("    const uint8_t* packed; // Compressed copy in QSPI (nullptr if not generated)")
+    lines.append("    // Multi-rate tail (see MultiRateConvolver.h); data/length are then the head.")
+    lines.append("    const float* tail;     // nullptr if not generated")
+    lines.append("    size_t tailLength;     // Decimated taps")
+    lines.append("    size_t tailRate;       // Decimation factor")
+    lines.append("    size_t tailSplit;      // Full-rate offset of the first tail tap")
     lines.append("};")
     lines.append("")
 
     # Add individual IR arrays with QSPI attribute
-    ir_names = []
-    ir_lengths = []
+    ir_entries = []
+    total_samples = 0
     for name, samples in ir_data:
         lines.append(f"// IR: {name} ({len(samples)} samples, {len(samples)/SAMPLE_RATE*1000:.1f}ms)")
-        lines.append(format_cpp_raw_array(samples, name, indent=0))
-        lines.append("")
-        ir_names.append(name)
-        ir_lengths.append(len(samples))
+        tail, split = None, 0
+        if multirate:
+            samples, tail, split = split_multirate(samples, multirate, split_ms)
+        total_samples += len(samples) + (len(tail) if tail else 0)
+        shift = weight_shift(samples)
+        if emit_float:
+            lines.append(format_cpp_raw_array(samples, name, indent=0))
+            lines.append("")
+        if emit_q15:
+            lines.append(f"// Q15, weight shift {shift}")
+            lines.append(format_cpp_int_array(quantize_ir(samples, 15, shift), f"{name}_q15", "int16_t"))
+            lines.append("")
+        if emit_q31:
+            lines.append(f"// Q31, weight shift {shift}")
+            lines.append(format_cpp_int_array(quantize_ir(samples, 31, shift), f"{name}_q31", "int32_t"))
+            lines.append("")
+        if spectra_partition:
+            lines.append(f"// Partitioned spectra, partition size {spectra_partition}")
+            lines.append(format_cpp_raw_array(partition_spectra(samples, spectra_partition), f"{name}_spectra"))
+            lines.append("")
+        if compress_bits:
+            packed = encode_block_float(samples, compress_bits)
+            lines.append(f"// Block floating point, {compress_bits}-bit mantissas")
+            lines.append(format_cpp_int_array(list(packed), f"{name}_packed", "uint8_t"))
+            lines.append("")
+        if tail:
+            lines.append(f"// Multi-rate tail from sample {split}, 1/{multirate} rate")
+            lines.append(format_cpp_raw_array(tail, f"{name}_tail"))
+            lines.append("")
+        ir_entries.append((
+            name,
+            name if emit_float else "nullptr",
+            len(samples),
+            f"{name}_q15" if emit_q15 else "nullptr",
+            f"{name}_q31" if emit_q31 else "nullptr",
+            shift if (emit_q15 or emit_q31) else 0,
+            "IRFormat::PartitionedSpectra" if spectra_partition else "IRFormat::Raw",
+            f"{name}_spectra" if spectra_partition else "nullptr",
+            spectra_partition,
+            f"IRCodec::BlockFloat{compress_bits}" if compress_bits else "IRCodec::None",
+            f"{name}_packed" if compress_bits else "nullptr",
+            f"{name}_tail" if tail else "nullptr",
+            len(tail) if tail else 0,
+            multirate if tail else 0,
+            split,
+        ))
+    ir_lengths = [len(samples) for _, samples in ir_data]
 
     # Add collection array (array of IRInfo structs)
-    lines.append(f"// Collection of all IRs for indexing ({len(ir_names)} total)")
-    lines.append(f"constexpr size_t IR_COUNT = {len(ir_names)};")
+    lines.append(f"// Collection of all IRs for indexing ({len(ir_entries)} total)")
+    lines.append(f"constexpr size_t IR_COUNT = {len(ir_entries)};")
     lines.append("")
     lines.append("const IRInfo ir_collection[IR_COUNT] = {")
-    for name, length in zip(ir_names, ir_lengths):
-        lines.append(f'    {{"{name}", {name}, {length}}},')
+    for (name, data, length, q15, q31, shift, fmt, spectra, partition, codec, packed,
+         tail, tail_length, tail_rate, tail_split) in ir_entries:
+        lines.append(f'    {{"{name}", {data}, {length}, {q15}, {q31}, {shift}, {fmt}, {spectra}, {partition}, '
+                     f'{codec}, {packed}, {tail}, {tail_length}, {tail_rate}, {tail_split}}},')
     lines.append("};")
     lines.append("")
 
@@ -223,12 +595,21 @@ def generate_header(ir_data, output_path):
     with open(output_path, 'w') as f:
         f.write('\n'.join(lines))
 
-    total_samples = sum(len(samples) for _, samples in ir_data)
+    bytes_per_sample = 4 * emit_float + 2 * emit_q15 + 4 * emit_q31
+    qspi_bytes = total_samples * bytes_per_sample
+    if spectra_partition:
+        for _, samples in ir_data:
+            partitions = max(1, (len(samples) + spectra_partition - 1) // spectra_partition)
+            qspi_bytes += partitions * (spectra_partition + 1) * 8
+    if compress_bits:
+        for _, samples in ir_data:
+            blocks = (len(samples) + BLOCK_FLOAT_SIZE - 1) // BLOCK_FLOAT_SIZE
+            qspi_bytes += blocks * (1 + BLOCK_FLOAT_SIZE if compress_bits == 8 else 2 + 2 * BLOCK_FLOAT_SIZE)
     print(f"\nGenerated header: {output_path}")
     print(f"  Total IRs: {len(ir_data)}")
     print(f"  Total samples: {total_samples}")
-    print(f"  Estimated QSPI size: ~{total_samples * 4 / 1024:.1f} KB")
-    print(f"  Estimated RAM per IR: ~{max(ir_lengths) * 4 / 1024:.1f} KB")
+    print(f"  Estimated QSPI size: ~{qspi_bytes / 1024:.1f} KB")
+    print(f"  Estimated RAM per IR: ~{max(ir_lengths) * 4 / 1024:.1f} KB (longest)")
 
 
 def main():
@@ -242,16 +623,73 @@ Examples:
 
   # Convert multiple IRs
   python3 wav_to_ir_header.py irs/*.wav -o src/ImpulseResponse/ir_data.h
+
+  # Q15 only, for make IR_PRECISION=q15 (half the QSPI footprint)
+  python3 wav_to_ir_header.py irs/*.wav -o src/ImpulseResponse/ir_data.h --q15 --no-float
+
+  # Pre-transformed partitions for make IR_ENGINE=partitioned at 8-sample blocks
+  python3 wav_to_ir_header.py irs/*.wav -o src/ImpulseResponse/ir_data.h --spectra 8
+
+  # A compressed library: 36 IRs in three banks at ~1/4 of the float size
+  python3 wav_to_ir_header.py irs/*.wav -o src/ImpulseResponse/ir_data.h --compress bfp8 --no-float
+
+  # Long room IRs: 20 ms at full rate, the rest at 1/4 rate (up to 680 ms)
+  python3 wav_to_ir_header.py irs/*.wav -o src/ImpulseResponse/ir_data.h --multirate 4
+
+  # Keep more of the tail, or keep the full fixed length
+  python3 wav_to_ir_header.py irs/*.wav -o src/ImpulseResponse/ir_data.h --trim-db -80
+  python3 wav_to_ir_header.py irs/*.wav -o src/ImpulseResponse/ir_data.h --no-trim
         """
     )
 
     parser.add_argument('wav_files', nargs='+', help='Input WAV file(s)')
     parser.add_argument('-o', '--output', required=True, help='Output header file path')
-    parser.add_argument('--max-length', type=int, default=MAX_IR_LENGTH_MS,
-                        help=f'Maximum IR length in ms (default: {MAX_IR_LENGTH_MS})')
+    parser.add_argument('--max-length', type=int, default=None,
+                        help=f'Maximum IR length in ms (default: {MAX_IR_LENGTH_MS}, '
+                             f'times the rate with --multirate)')
+    parser.add_argument('--trim-db', type=float, default=DEFAULT_TRIM_DB,
+                        help=f'Drop the tail once its residual energy is below this, in dB '
+                             f'(default: {DEFAULT_TRIM_DB:.0f})')
+    parser.add_argument('--fade-ms', type=float, default=DEFAULT_FADE_MS,
+                        help=f'Fade-out length at the trim point in ms (default: {DEFAULT_FADE_MS})')
+    parser.add_argument('--no-trim', action='store_true',
+                        help='Pad/trim every IR to exactly --max-length instead of auto-trimming')
+    parser.add_argument('--q15', action='store_true',
+                        help='Also emit Q15 coefficient arrays for the fixed-point engine')
+    parser.add_argument('--q31', action='store_true',
+                        help='Also emit Q31 coefficient arrays for the fixed-point engine')
+    parser.add_argument('--spectra', type=int, default=0, metavar='PARTITION',
+                        help='Also emit pre-transformed spectra for the partitioned engine with this '
+                             'partition size (the audio block size, a power of two)')
+    parser.add_argument('--compress', choices=['bfp8', 'bfp16'],
+                        help='Also emit a block floating point copy with 8- or 16-bit mantissas, '
+                             'decoded into RAM on load')
+    parser.add_argument('--multirate', type=int, choices=[2, 4], default=0, metavar='RATE',
+                        help='Split each IR for the multi-rate engine: full rate up to --split-ms, '
+                             'the tail at 1/RATE of the sample rate')
+    parser.add_argument('--split-ms', type=float, default=DEFAULT_SPLIT_MS,
+                        help=f'Multi-rate split point in ms (default: {DEFAULT_SPLIT_MS:.0f})')
+    parser.add_argument('--no-float', action='store_true',
+                        help='Omit the float arrays (requires --q15, --q31, --spectra or --compress)')
 
     args = parser.parse_args()
 
+    if args.no_float and not (args.q15 or args.q31 or args.spectra or args.compress):
+        print("Error: --no-float needs --q15, --q31, --spectra or --compress", file=sys.stderr)
+        return 1
+
+    if args.multirate and (args.no_float or args.q15 or args.q31 or args.spectra or args.compress):
+        print("Error: --multirate runs a float head and can't be combined with --no-float, "
+              "--q15, --q31, --spectra or --compress", file=sys.stderr)
+        return 1
+
+    if args.max_length is None:
+        args.max_length = MAX_IR_LENGTH_MS * max(1, args.multirate)
+
+    if args.spectra < 0 or (args.spectra & (args.spectra - 1)) != 0:
+        print("Error: --spectra must be a power of two", file=sys.stderr)
+        return 1
+
     # Validate input files
     wav_files = []
     for pattern in args.wav_files:
@@ -266,7 +704,8 @@ Examples:
         return 1
 
     if len(wav_files) > MAX_IR_COUNT:
-        print(f"Warning: Found {len(wav_files)} files, but only {MAX_IR_COUNT} IRs supported. Using first {MAX_IR_COUNT}.")
+        print(f"Warning: Found {len(wav_files)} files, but only {MAX_IR_COUNT} IRs supported "
+              f"({IR_BANK_COUNT} banks of {IR_BANK_SIZE}). Using first {MAX_IR_COUNT}.")
         wav_files = wav_files[:MAX_IR_COUNT]
 
     # Process each WAV file
@@ -283,8 +722,15 @@ Examples:
                 print(f"  Warning: Sample rate is {sample_rate}Hz, expected {SAMPLE_RATE}Hz")
                 print(f"  Resampling not implemented - IR may sound incorrect!")
 
-            # Trim or pad to target length
-            samples = trim_or_pad_ir(samples, max_samples)
+            # Cap at the maximum length, then drop the tail below the noise
+            # floor so shorter IRs cost fewer MACs at runtime
+            if args.no_trim:
+                samples = trim_or_pad_ir(samples, max_samples)
+            else:
+                if len(samples) > max_samples:
+                    print(f"  Trimming from {len(samples)} to {max_samples} samples")
+                    samples = samples[:max_samples]
+                samples = auto_trim_ir(samples, args.trim_db, args.fade_ms)
 
             # Generate C++ variable name
             var_name = sanitize_name(wav_path)
@@ -303,7 +749,10 @@ Examples:
     # Generate header file
     output_path = Path(args.output)
     output_path.parent.mkdir(parents=True, exist_ok=True)
-    generate_header(ir_data, output_path)
+    generate_header(ir_data, output_path, emit_float=not args.no_float,
+                    emit_q15=args.q15, emit_q31=args.q31, spectra_partition=args.spectra,
+                    compress_bits={'bfp8': 8, 'bfp16': 16}.get(args.compress, 0),
+                    multirate=args.multirate, split_ms=args.split_ms)
 
     print("\nDone!")
     return 0